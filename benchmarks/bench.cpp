@@ -0,0 +1,86 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+double BenchResult::Mean() const
+{
+    if (samplesNs.empty()) return 0;
+    return std::accumulate(samplesNs.begin(), samplesNs.end(), 0.0) / samplesNs.size();
+}
+
+double BenchResult::Percentile(double p) const
+{
+    if (samplesNs.empty()) return 0;
+    // Nearest-rank on the sorted samples
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samplesNs.size()));
+    return samplesNs[std::clamp<size_t>(rank, 1, samplesNs.size()) - 1];
+}
+
+double BenchResult::ItemsPerSecond() const
+{
+    double mean = Mean();
+    return mean > 0 ? itemsPerIteration * 1e9 / mean : 0;
+}
+
+void BenchState::Measure(double itemsPerIteration, const std::function<void()>& body)
+{
+    using clock = std::chrono::steady_clock;
+
+    body();   // Warm-up: faults in pages, fills caches, grows reused buffers
+
+    auto& samples = m_result.samplesNs;
+    samples.clear();
+    samples.reserve(m_config.minIterations);
+
+    AllocStats allocs{};
+    const auto start = clock::now();
+    for (;;) {
+        // Allocation counts are taken around the body only, so the harness's own
+        // bookkeeping (growing `samples`) is not attributed to it.
+        const AllocStats before = CurrentAllocs();
+        const auto t0 = clock::now();
+        body();
+        const auto t1 = clock::now();
+        const AllocStats after = CurrentAllocs();
+
+        allocs.count += after.count - before.count;
+        allocs.bytes += after.bytes - before.bytes;
+        samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+
+        const double elapsed = std::chrono::duration<double>(t1 - start).count();
+        if (samples.size() >= m_config.maxIterations) break;
+        if (samples.size() >= m_config.minIterations && elapsed >= m_config.minSeconds) break;
+    }
+
+    std::ranges::sort(samples);
+    m_result.iterations = samples.size();
+    m_result.itemsPerIteration = itemsPerIteration;
+    m_result.allocsPerIteration = static_cast<double>(allocs.count) / samples.size();
+    m_result.allocBytesPerIteration = static_cast<double>(allocs.bytes) / samples.size();
+}
+
+std::vector<Benchmark>& Registry()
+{
+    static std::vector<Benchmark> registry;
+    return registry;
+}
+
+bool RegisterBenchmarks(std::vector<Benchmark> benchmarks)
+{
+    auto& registry = Registry();
+    std::ranges::move(benchmarks, std::back_inserter(registry));
+    return true;
+}
+
+std::vector<std::string> MakeLines(DataShape shape, size_t rows, uint64_t seed)
+{
+    DataGenerator generator({.shape = shape, .rows = rows, .seed = seed});
+    std::vector<std::string> lines;
+    lines.reserve(rows);
+    for (std::string line; generator.AppendNext(line); line.clear()) {
+        lines.push_back(line);
+    }
+    return lines;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "alloc_hook.hpp"
+#include "datagen.hpp"
+
+// Minimal benchmark harness: repeated timed samples, latency percentiles,
+// throughput and heap allocation counts, reported as a table and as JSON.
+
+struct BenchResult {
+    std::string name;
+    size_t rows = 0;                 // Dataset size, 0 for size-independent benchmarks
+    size_t iterations = 0;
+    double itemsPerIteration = 0;
+    std::vector<double> samplesNs;   // One per iteration, sorted ascending
+    double allocsPerIteration = 0;
+    double allocBytesPerIteration = 0;
+
+    double Mean() const;
+    double Percentile(double p) const;
+    double ItemsPerSecond() const;
+};
+
+struct BenchConfig {
+    double minSeconds = 0.5;        // Keep sampling until this much time is spent...
+    size_t minIterations = 5;       // ...and at least this many samples are taken,
+    size_t maxIterations = 100000;  // but never more than this.
+};
+
+class BenchState
+{
+public:
+    BenchState(std::string name, size_t rows, const BenchConfig& config)
+        : m_config(config) { m_result.name = std::move(name); m_result.rows = rows; }
+
+    size_t Rows() const { return m_result.rows; }
+
+    // Times repeated calls of body, after one untimed warm-up call.
+    // itemsPerIteration is the unit of throughput (rows, bytes, ...).
+    void Measure(double itemsPerIteration, const std::function<void()>& body);
+
+    const BenchResult& Result() const { return m_result; }
+
+private:
+    const BenchConfig& m_config;
+    BenchResult m_result;
+};
+
+enum class BenchScale {
+    Fixed,     // Runs once
+    PerSize,   // Runs once per dataset size
+};
+
+struct Benchmark {
+    std::string name;
+    BenchScale scale = BenchScale::Fixed;
+    std::function<void(BenchState&)> run;
+};
+
+// Adds benchmarks to the global registry; use from a namespace-scope initializer.
+bool RegisterBenchmarks(std::vector<Benchmark> benchmarks);
+std::vector<Benchmark>& Registry();
+
+// Keeps the compiler from discarding a computed value.
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// `rows` synthetic rows of the given shape, the same for every run.
+std::vector<std::string> MakeLines(DataShape shape, size_t rows, uint64_t seed = 42);
@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+
+#include "bench.hpp"
+#include "RowTable.hpp"
+
+namespace {
+
+// Writes a synthetic dataset to a temporary file, removed on destruction.
+class TempDataset
+{
+public:
+    TempDataset(DataShape shape, size_t rows)
+        : m_path(std::filesystem::temp_directory_path()
+                 / ("fxf-bench-" + std::string(DataShapeName(shape)) + "-" + std::to_string(rows) + ".txt"))
+    {
+        std::unique_ptr<std::FILE, decltype(&std::fclose)> file(std::fopen(m_path.c_str(), "wb"), std::fclose);
+        if (!file || !WriteDataset({.shape = shape, .rows = rows}, file.get())) std::abort();
+    }
+
+    ~TempDataset() { std::error_code ec; std::filesystem::remove(m_path, ec); }
+
+    std::string Path() const { return m_path.string(); }
+
+private:
+    std::filesystem::path m_path;
+};
+
+std::vector<Benchmark> LoadBenchmarks()
+{
+    std::vector<Benchmark> benchmarks;
+    for (DataShape shape : {DataShape::Paths, DataShape::Vimgrep, DataShape::Table, DataShape::Log, DataShape::Unicode}) {
+        benchmarks.push_back({"load/RowTable::Load " + std::string(DataShapeName(shape)), BenchScale::PerSize, [shape](BenchState& state) {
+            TempDataset dataset(shape, state.Rows());
+            RowTable table;
+            state.Measure(state.Rows(), [&] {
+                if (!table.Load(dataset.Path(), '|')) std::abort();
+                DoNotOptimize(table.data.size());
+            });
+        }});
+    }
+
+    benchmarks.push_back({"load/RowTable::AddLine vimgrep", BenchScale::PerSize, [](BenchState& state) {
+        const auto lines = MakeLines(DataShape::Vimgrep, state.Rows());
+        RowTable table;
+        state.Measure(state.Rows(), [&] {
+            table.Clear();
+            for (const std::string& line : lines) table.AddLine(line, '|');
+            DoNotOptimize(table.data.size());
+        });
+    }});
+    return benchmarks;
+}
+
+const bool registered = RegisterBenchmarks(LoadBenchmarks());
+
+}
@@ -0,0 +1,154 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <ranges>
+#include <CLI/CLI.hpp>
+
+#include "bench.hpp"
+
+// Parses "10k,1m,10m" into row counts.
+static bool ParseSizes(const std::string& text, std::vector<size_t>& sizes)
+{
+    sizes.clear();
+    for (auto part : std::views::split(text, ',')) {
+        auto count = ParseCount(std::string_view(part.begin(), part.end()));
+        if (!count || *count == 0) return false;
+        sizes.push_back(*count);
+    }
+    return !sizes.empty();
+}
+
+static std::string FormatNs(double ns)
+{
+    char buf[32];
+    if (ns < 1e3) std::snprintf(buf, sizeof buf, "%.0f ns", ns);
+    else if (ns < 1e6) std::snprintf(buf, sizeof buf, "%.2f us", ns / 1e3);
+    else if (ns < 1e9) std::snprintf(buf, sizeof buf, "%.2f ms", ns / 1e6);
+    else std::snprintf(buf, sizeof buf, "%.2f s", ns / 1e9);
+    return buf;
+}
+
+static std::string FormatRate(double perSecond)
+{
+    char buf[32];
+    if (perSecond >= 1e9) std::snprintf(buf, sizeof buf, "%.2f G/s", perSecond / 1e9);
+    else if (perSecond >= 1e6) std::snprintf(buf, sizeof buf, "%.2f M/s", perSecond / 1e6);
+    else if (perSecond >= 1e3) std::snprintf(buf, sizeof buf, "%.2f k/s", perSecond / 1e3);
+    else std::snprintf(buf, sizeof buf, "%.2f /s", perSecond);
+    return buf;
+}
+
+static void PrintHeader()
+{
+    std::printf("%-48s %9s %7s %11s %11s %11s %12s %10s\n",
+                "benchmark", "rows", "iters", "p50", "p90", "p99", "throughput", "allocs/it");
+}
+
+static void PrintRow(const BenchResult& r)
+{
+    std::printf("%-48s %9zu %7zu %11s %11s %11s %12s %10.1f\n",
+                r.name.c_str(), r.rows, r.iterations,
+                FormatNs(r.Percentile(50)).c_str(), FormatNs(r.Percentile(90)).c_str(),
+                FormatNs(r.Percentile(99)).c_str(), FormatRate(r.ItemsPerSecond()).c_str(),
+                r.allocsPerIteration);
+    std::fflush(stdout);
+}
+
+static std::string JsonEscape(std::string_view text)
+{
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static bool WriteJson(const std::string& path, const std::vector<BenchResult>& results)
+{
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << "{\n";
+#ifdef NDEBUG
+    out << "  \"assertions\": false,\n";
+#else
+    out << "  \"assertions\": true,\n";
+#endif
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << JsonEscape(r.name) << "\""
+            << ", \"rows\": " << r.rows
+            << ", \"iterations\": " << r.iterations
+            << ", \"mean_ns\": " << r.Mean()
+            << ", \"min_ns\": " << r.Percentile(0)
+            << ", \"p50_ns\": " << r.Percentile(50)
+            << ", \"p90_ns\": " << r.Percentile(90)
+            << ", \"p99_ns\": " << r.Percentile(99)
+            << ", \"max_ns\": " << r.Percentile(100)
+            << ", \"items_per_second\": " << r.ItemsPerSecond()
+            << ", \"allocs_per_iteration\": " << r.allocsPerIteration
+            << ", \"alloc_bytes_per_iteration\": " << r.allocBytesPerIteration
+            << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char* argv[])
+{
+    CLI::App args{"fxf benchmarks"};
+
+    std::string filter;
+    std::string sizesText = "10k,1m";
+    std::string jsonPath;
+    bool list = false;
+    BenchConfig config;
+    args.add_option("filter", filter, "Run only benchmarks whose name contains this text");
+    args.add_option("--sizes", sizesText, "Comma-separated dataset sizes in rows, e.g. 10k,1m,10m");
+    args.add_option("--json", jsonPath, "Also write results as JSON to this file");
+    args.add_option("--min-time", config.minSeconds, "Minimum seconds to sample each benchmark");
+    args.add_option("--min-iters", config.minIterations, "Minimum samples per benchmark");
+    args.add_flag("--list", list, "List benchmark names and exit");
+
+    CLI11_PARSE(args, argc, argv);
+
+    std::vector<size_t> sizes;
+    if (!ParseSizes(sizesText, sizes)) {
+        std::cerr << "Error: Invalid --sizes: " << sizesText << "\n";
+        return 2;
+    }
+
+    std::vector<Benchmark> selected;
+    for (const Benchmark& benchmark : Registry()) {
+        if (benchmark.name.find(filter) != std::string::npos) selected.push_back(benchmark);
+    }
+    if (list) {
+        for (const Benchmark& benchmark : selected) std::cout << benchmark.name << "\n";
+        return 0;
+    }
+
+#ifndef NDEBUG
+    std::cerr << "Warning: assertions are enabled; configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n";
+#endif
+
+    std::vector<BenchResult> results;
+    PrintHeader();
+    for (const Benchmark& benchmark : selected) {
+        std::vector<size_t> runSizes = benchmark.scale == BenchScale::PerSize ? sizes : std::vector<size_t>{0};
+        for (size_t rows : runSizes) {
+            BenchState state(benchmark.name, rows, config);
+            benchmark.run(state);
+            if (state.Result().iterations == 0) continue;
+            PrintRow(state.Result());
+            results.push_back(state.Result());
+        }
+    }
+
+    if (!jsonPath.empty() && !WriteJson(jsonPath, results)) {
+        std::cerr << "Error: Cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.hpp"
+#include "process.hpp"
+
+namespace {
+
+// About 32 MB of 64-byte lines, like a large modal command's output
+const std::string kLinesCommand = "yes 'the quick brown fox jumps over the lazy dog 0123456789 abcdef' | head -c 32000000";
+
+// Resident memory standing in for a large loaded dataset, which fork() has to
+// copy the page tables of
+constexpr size_t kResidentBytes = 512 * 1024 * 1024;
+
+// How command output was captured before: popen() read 128 bytes at a time with fgets()
+std::string PopenCapture(const std::string& cmd)
+{
+    char buffer[128];
+    std::string result;
+    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
+    while (pipe && fgets(buffer, sizeof buffer, pipe.get()) != nullptr) {
+        result += buffer;
+    }
+    return result;
+}
+
+// How silent commands were started before
+int ForkExec(char* const argv[])
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+std::vector<char> ResidentMemory()
+{
+    std::vector<char> memory(kResidentBytes);
+    std::memset(memory.data(), 1, memory.size());
+    return memory;
+}
+
+const bool registered = RegisterBenchmarks({
+    {"process/popen + fgets, 32 MB (before)", BenchScale::Fixed, [](BenchState& state) {
+        state.Measure(1, [&] { DoNotOptimize(PopenCapture(kLinesCommand)); });
+    }},
+
+    {"process/RunShell, 32 MB", BenchScale::Fixed, [](BenchState& state) {
+        state.Measure(1, [&] { DoNotOptimize(RunShell(kLinesCommand)); });
+    }},
+
+    {"process/fork + exec true, 512 MiB resident (before)", BenchScale::Fixed, [](BenchState& state) {
+        auto memory = ResidentMemory();
+        char name[] = "true";
+        char* argv[] = {name, nullptr};
+        state.Measure(1, [&] { DoNotOptimize(ForkExec(argv)); });
+        DoNotOptimize(memory);
+    }},
+
+    {"process/RunProcess true, 512 MiB resident", BenchScale::Fixed, [](BenchState& state) {
+        auto memory = ResidentMemory();
+        state.Measure(1, [&] { DoNotOptimize(RunProcess({"true"}, {.captureOutput = false})); });
+        DoNotOptimize(memory);
+    }},
+});
+
+}
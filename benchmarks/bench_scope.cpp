@@ -0,0 +1,193 @@
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <unordered_set>
+
+#include "bench.hpp"
+#include "dirlist.hpp"
+#include "process.hpp"
+#include "scope.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kCorpusRows = 10'000;
+
+// `rg --vimgrep` output as it is actually printed, colon-separated
+std::vector<std::string> VimgrepLines()
+{
+    DataGenerator generator({.shape = DataShape::Vimgrep, .rows = kCorpusRows, .delimiter = ':'});
+    std::vector<std::string> lines;
+    for (std::string line; generator.AppendNext(line); line.clear()) lines.push_back(line);
+    return lines;
+}
+
+// VimgrepLines() in a scratch directory where every other distinct path exists, so Parse sees both hits and fall-throughs. The
+// working directory is switched to it for the lifetime of the object.
+class VimgrepTree
+{
+public:
+    VimgrepTree()
+        : m_root(fs::temp_directory_path() / "fxf-bench-scope"), m_previous(fs::current_path())
+    {
+        fs::remove_all(m_root);
+        fs::create_directories(m_root);
+        fs::current_path(m_root);
+
+        std::unordered_set<std::string> seen;
+        for (const std::string& line : lines) {
+            std::string path = line.substr(0, line.find(':'));
+            if (seen.insert(path).second && seen.size() % 2 == 0) {
+                fs::create_directories(fs::path(path).parent_path());
+                std::ofstream(path) << "line\n";
+            }
+        }
+    }
+
+    ~VimgrepTree()
+    {
+        std::error_code ec;
+        fs::current_path(m_previous, ec);
+        fs::remove_all(m_root, ec);
+    }
+
+    const std::vector<std::string> lines = VimgrepLines();
+
+private:
+    fs::path m_root;
+    fs::path m_previous;
+};
+
+// A scratch directory of `count` empty files, removed on destruction.
+class WideDirectory
+{
+public:
+    explicit WideDirectory(size_t count)
+        : m_root(fs::temp_directory_path() / ("fxf-bench-dir-" + std::to_string(count)))
+    {
+        fs::remove_all(m_root);
+        fs::create_directories(m_root);
+        for (size_t i = 0; i < count; ++i) {
+            std::ofstream(m_root / ("file-" + std::to_string(i * 7919 % count) + ".txt"));
+        }
+    }
+
+    ~WideDirectory() { std::error_code ec; fs::remove_all(m_root, ec); }
+
+    std::string Path() const { return m_root.string(); }
+
+private:
+    fs::path m_root;
+};
+
+// Scope::Parse as it was before the hand-written scanners and StatCache:
+// regex matching plus separate filesystem queries for every question.
+ParsedContent RegexParse(const std::string& input)
+{
+    static const std::regex vimgrepRegex(R"(^(.+?):(\d+):(\d+):.*$)");
+    static const std::regex grepRegex(R"(^(.+?):(\d+):.*$)");
+
+    ParsedContent result;
+    result.rawContent = input;
+    std::string trimmed = trim(input);
+    if (trimmed.empty()) return result;
+
+    std::smatch match;
+    if (std::regex_match(trimmed, match, vimgrepRegex)) {
+        std::string filepath = match[1].str();
+        if (fs::exists(filepath) && fs::is_regular_file(filepath)) {
+            result.type = ContentType::VimgrepOutput;
+            result.filepath = filepath;
+            result.line = std::stoi(match[2].str());
+            result.col = std::stoi(match[3].str());
+            return result;
+        }
+    }
+    if (std::regex_match(trimmed, match, grepRegex)) {
+        std::string filepath = match[1].str();
+        if (fs::exists(filepath) && fs::is_regular_file(filepath)) {
+            result.type = ContentType::GrepOutput;
+            result.filepath = filepath;
+            result.line = std::stoi(match[2].str());
+            return result;
+        }
+    }
+
+    static const std::regex urlRegex(
+        R"(https?://(?:www\.)?[-a-zA-Z0-9@:%._+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b[-a-zA-Z0-9()@:%_+.~#?&/=]*)",
+        std::regex::icase);
+    if (std::regex_search(trimmed, match, urlRegex)) {
+        result.type = ContentType::URL;
+        result.url = match[0].str();
+        return result;
+    }
+
+    if (fs::exists(trimmed)) {
+        if (fs::is_regular_file(trimmed)) {
+            result.type = ContentType::FilePath;
+        } else if (fs::is_directory(trimmed)) {
+            result.type = ContentType::Directory;
+        }
+        if (result.type != ContentType::Unknown) result.filepath = trimmed;
+    }
+    return result;
+}
+
+const bool registered = RegisterBenchmarks({
+    {"scope/Parse regex + filesystem (before)", BenchScale::Fixed, [](BenchState& state) {
+        VimgrepTree tree;
+        state.Measure(tree.lines.size(), [&] {
+            for (const std::string& line : tree.lines) DoNotOptimize(RegexParse(line));
+        });
+    }},
+
+    // Stat cache emptied each iteration, as for output seen for the first time
+    {"scope/Parse cold", BenchScale::Fixed, [](BenchState& state) {
+        VimgrepTree tree;
+        Scope scope;
+        state.Measure(tree.lines.size(), [&] {
+            scope.ClearCache();
+            for (const std::string& line : tree.lines) DoNotOptimize(scope.Parse(line));
+        });
+    }},
+
+    // The text scanners alone, without any filesystem access
+    {"scope/regex_match vimgrep + grep", BenchScale::Fixed, [](BenchState& state) {
+        const auto lines = VimgrepLines();
+        const std::regex vimgrepRegex(R"(^(.+?):(\d+):(\d+):.*$)");
+        const std::regex grepRegex(R"(^(.+?):(\d+):.*$)");
+        std::smatch match;
+        state.Measure(lines.size(), [&] {
+            for (const std::string& line : lines) {
+                DoNotOptimize(std::regex_match(line, match, vimgrepRegex));
+                DoNotOptimize(std::regex_match(line, match, grepRegex));
+            }
+        });
+    }},
+
+    {"scope/FindLineReferences", BenchScale::Fixed, [](BenchState& state) {
+        const auto lines = VimgrepLines();
+        state.Measure(lines.size(), [&] {
+            for (const std::string& line : lines) DoNotOptimize(FindLineReferences(line));
+        });
+    }},
+
+    // Directory previews: what RenderDirectory ran before, and what it runs now
+    {"scope/ls -la | head -n 50 (100k entries)", BenchScale::Fixed, [](BenchState& state) {
+        WideDirectory dir(100'000);
+        const std::string cmd = "ls -la '" + dir.Path() + "' 2>/dev/null | head -n 50";
+        state.Measure(1, [&] { DoNotOptimize(RunShell(cmd)); });
+    }},
+
+    {"scope/ListDirectory + FormatListing (100k entries)", BenchScale::Fixed, [](BenchState& state) {
+        WideDirectory dir(100'000);
+        state.Measure(1, [&] {
+            auto listing = ListDirectory(dir.Path(), 50);
+            DoNotOptimize(FormatListing(*listing));
+        });
+    }},
+});
+
+}
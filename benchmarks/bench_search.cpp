@@ -0,0 +1,42 @@
+#include <numeric>
+
+#include "bench.hpp"
+#include "search.hpp"
+#include "utils.hpp"
+
+namespace {
+
+std::vector<size_t> Identity(size_t n)
+{
+    std::vector<size_t> indices(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    return indices;
+}
+
+// One benchmark per query: a short lowercase query matches broadly, an
+// uppercase one takes the case-sensitive path.
+Benchmark ExtractBenchmark(std::string query)
+{
+    return {"search/extract \"" + query + "\"", BenchScale::PerSize, [query](BenchState& state) {
+        const auto labels = MakeLines(DataShape::Vimgrep, state.Rows());
+        state.Measure(state.Rows(), [&] { DoNotOptimize(extract(query, labels)); });
+    }};
+}
+
+Benchmark RankBenchmark(std::string query)
+{
+    return {"search/RankMatches \"" + query + "\"", BenchScale::PerSize, [query](BenchState& state) {
+        const auto labels = MakeLines(DataShape::Vimgrep, state.Rows());
+        const auto candidates = Identity(labels.size());
+        state.Measure(state.Rows(), [&] { DoNotOptimize(RankMatches(query, labels, candidates)); });
+    }};
+}
+
+const bool registered = RegisterBenchmarks({
+    ExtractBenchmark("parser"),
+    ExtractBenchmark("TODO"),
+    RankBenchmark("src/main"),
+    RankBenchmark("buffer index"),
+});
+
+}
@@ -0,0 +1,132 @@
+#include "bench.hpp"
+#include "RowTable.hpp"
+#include "template.hpp"
+
+namespace {
+
+// What substitute_template did before templates were compiled: parse the
+// template again for every row.
+std::string ParsePerRow(std::string_view template_str, const std::vector<std::string>& data)
+{
+    std::string result;
+    result.reserve(template_str.size() * 2);
+
+    std::string joined_data;
+    bool joined_computed = false;
+
+    size_t i = 0;
+    while (i < template_str.size()) {
+        if (template_str[i] == '{') {
+            size_t close = template_str.find('}', i + 1);
+            if (close != std::string_view::npos) {
+                std::string_view inner = template_str.substr(i + 1, close - i - 1);
+
+                if (inner.empty()) {
+                    // {} placeholder - lazy compute joined_data
+                    if (!joined_computed) {
+                        if (!data.empty()) {
+                            size_t total_len = data[0].size();
+                            for (size_t j = 1; j < data.size(); ++j) {
+                                total_len += 3 + data[j].size();
+                            }
+                            joined_data.reserve(total_len);
+                            joined_data = data[0];
+                            for (size_t j = 1; j < data.size(); ++j) {
+                                joined_data += " | ";
+                                joined_data += data[j];
+                            }
+                        }
+                        joined_computed = true;
+                    }
+                    result += joined_data;
+                } else {
+                    // Parse {N} placeholder
+                    size_t idx = 0;
+                    bool valid = true;
+                    for (char c : inner) {
+                        if (c >= '0' && c <= '9') {
+                            idx = idx * 10 + (c - '0');
+                        } else {
+                            valid = false;
+                            break;
+                        }
+                    }
+
+                    if (valid && idx < data.size()) {
+                        result += data[idx];
+                    } else {
+                        result.append(template_str.substr(i, close - i + 1));
+                    }
+                }
+                i = close + 1;
+                continue;
+            }
+        }
+        result += template_str[i];
+        ++i;
+    }
+
+    return result;
+}
+
+std::vector<std::string> MakeRow(size_t columns)
+{
+    std::vector<std::string> row;
+    for (size_t i = 0; i < columns; ++i) {
+        row.push_back("column-value-" + std::to_string(i));
+    }
+    return row;
+}
+
+std::string MakeTemplate(size_t placeholders)
+{
+    std::string tpl;
+    for (size_t i = 0; i < placeholders; ++i) {
+        tpl += "{" + std::to_string(i) + "} : ";
+    }
+    return tpl;
+}
+
+// Per-row substitution micro benchmarks at a few template sizes
+std::vector<Benchmark> TemplateMicro()
+{
+    std::vector<Benchmark> benchmarks;
+    for (size_t placeholders : {4, 16, 32}) {
+        const std::string suffix = " (" + std::to_string(placeholders) + " placeholders)";
+
+        benchmarks.push_back({"template/parse per row (before)" + suffix, BenchScale::Fixed, [placeholders](BenchState& state) {
+            const auto row = MakeRow(32);
+            const std::string source = MakeTemplate(placeholders);
+            state.Measure(1, [&] { DoNotOptimize(ParsePerRow(source, row)); });
+        }});
+
+        benchmarks.push_back({"template/Render" + suffix, BenchScale::Fixed, [placeholders](BenchState& state) {
+            const auto row = MakeRow(32);
+            const CompiledTemplate compiled(MakeTemplate(placeholders));
+            state.Measure(1, [&] { DoNotOptimize(compiled.Render(row)); });
+        }});
+
+        benchmarks.push_back({"template/RenderInto reused buffer" + suffix, BenchScale::Fixed, [placeholders](BenchState& state) {
+            const auto row = MakeRow(32);
+            const CompiledTemplate compiled(MakeTemplate(placeholders));
+            std::string out;
+            state.Measure(1, [&] {
+                out.clear();
+                compiled.RenderInto(out, row);
+                DoNotOptimize(out.data());
+            });
+        }});
+    }
+    return benchmarks;
+}
+
+const bool registered = RegisterBenchmarks(TemplateMicro()) && RegisterBenchmarks({
+    {"template/GetMenuEntries {0}:{1} {3}", BenchScale::PerSize, [](BenchState& state) {
+        RowTable table;
+        for (const std::string& line : MakeLines(DataShape::Vimgrep, state.Rows())) table.AddLine(line, '|');
+        const CompiledTemplate compiled("{0}:{1} {3}");
+        state.Measure(state.Rows(), [&] { DoNotOptimize(table.GetMenuEntries(compiled)); });
+    }},
+});
+
+}
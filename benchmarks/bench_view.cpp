@@ -0,0 +1,67 @@
+#include <algorithm>
+
+#include "bench.hpp"
+#include "app.hpp"
+
+namespace {
+
+// Fills the App singleton with a fresh dataset of state.Rows() rows.
+App& PrepareApp(BenchState& state, std::string_view viewTemplate, DataShape shape = DataShape::Vimgrep)
+{
+    App& app = App::Instance();
+    app.state.lines.Clear();
+    for (const std::string& line : MakeLines(shape, state.Rows())) {
+        app.state.lines.AddLine(line, '|');
+    }
+    app.controls.viewTemplate = viewTemplate;
+    app.controls.filters.clear();
+    app.controls.sortSpec.reset();
+    app.controls.selections.Clear();
+    app.ResetView();
+    app.cache.menuEntries = app.state.lines.GetMenuEntries(app.CompiledViewTemplate());
+    return app;
+}
+
+const bool registered = RegisterBenchmarks({
+    {"view/UpdateFilteredView {}", BenchScale::PerSize, [](BenchState& state) {
+        App& app = PrepareApp(state, "{}");
+        state.Measure(state.Rows(), [&] { app.UpdateFilteredView(); });
+    }},
+
+    {"view/UpdateFilteredView {0}:{1} {3}", BenchScale::PerSize, [](BenchState& state) {
+        App& app = PrepareApp(state, "{0}:{1} {3}");
+        state.Measure(state.Rows(), [&] { app.UpdateFilteredView(); });
+    }},
+
+    {"view/UpdateFilteredView unicode", BenchScale::PerSize, [](BenchState& state) {
+        App& app = PrepareApp(state, "{0} {2}", DataShape::Unicode);
+        state.Measure(state.Rows(), [&] { app.UpdateFilteredView(); });
+    }},
+
+    // The per-keystroke path after ranking: show the cached labels in ranked order
+    {"view/RefreshFilteredView", BenchScale::PerSize, [](BenchState& state) {
+        App& app = PrepareApp(state, "{}");
+        std::reverse(app.controls.filteredIndices.begin(), app.controls.filteredIndices.end());
+        state.Measure(state.Rows(), [&] { app.RefreshFilteredView(); });
+    }},
+
+    // One search keystroke after warm-up: rank the base view, show it through the search labels
+    {"view/ApplySearch keystroke", BenchScale::PerSize, [](BenchState& state) {
+        App& app = PrepareApp(state, "{}");
+        const char* queries[] = {"s", "sr", "src", "src/", "src/m"};
+        size_t next = 0;
+        state.Measure(state.Rows(), [&] {
+            app.controls.searchDialog.string = queries[next++ % std::size(queries)];
+            app.ApplySearch();
+        });
+    }},
+
+    {"view/ResetView sort+where", BenchScale::PerSize, [](BenchState& state) {
+        App& app = PrepareApp(state, "{}");
+        app.controls.filters = {*ParsePredicate({"1", "<", "2500"})};
+        app.controls.sortSpec = ParseSortSpec({"2", "numeric", "desc"});
+        state.Measure(state.Rows(), [&] { app.ResetView(); });
+    }},
+});
+
+}
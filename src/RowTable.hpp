@@ -4,8 +4,11 @@
 #include <ranges>
 #include <fstream>
 #include <expected>
+#include <atomic>
 
 #include "utils.hpp"
+#include "template.hpp"
+#include "perf.hpp"
 
 struct RowTable
 {
@@ -13,12 +16,26 @@ struct RowTable
 
     std::vector<row_t> data;
 
+    // Bumped by every mutating method below and unique across tables, so caches
+    // derived from the rows (e.g. ColumnCache) can tell when they are stale.
+    // Code that edits `data` directly must call Touch().
+    uint64_t generation = NextGeneration();
+
+    static uint64_t NextGeneration()
+    {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    void Touch() { generation = NextGeneration(); }
+
     auto& operator[](size_t idx) { return data[idx]; }
     const auto& operator[](size_t idx) const { return data[idx]; }
 
     auto AddLine(std::string_view line, char delimiter)
     {
         data.emplace_back(line | std::views::split(delimiter) | std::ranges::to<row_t>());
+        Touch();
     }
 
     auto GetRow(size_t idx) const
@@ -39,11 +56,19 @@ struct RowTable
     {
         if(idx >= data.size()) return;
         data.erase(data.begin() + idx);
+        Touch();
     }
 
-    std::expected<void, std::string> Load(std::string_view filename, char delimiter)
+    void Clear()
     {
         data.clear();
+        Touch();
+    }
+
+    std::expected<void, std::string> Load(std::string_view filename, char delimiter)
+    {
+        ScopedTimer timer(PerfStage::Load);
+        Clear();
         std::ifstream file(std::string{filename});
         if(!file)
         {
@@ -57,19 +82,31 @@ struct RowTable
         return {};
     }
 
-    std::vector<std::string> GetMenuEntries(std::string_view viewTemplate) const
+    std::vector<std::string> GetMenuEntries(const CompiledTemplate& viewTemplate) const
     {
         std::vector<std::string> entries;
+        entries.reserve(data.size());
         for(const row_t& row : data)
         {
-            entries.emplace_back(substitute_template(viewTemplate, row));
+            entries.emplace_back(viewTemplate.Render(row));
         }
         return entries;
     }
 
+    std::vector<std::string> GetMenuEntries(std::string_view viewTemplate) const
+    {
+        return GetMenuEntries(CompiledTemplate(viewTemplate));
+    }
+
+    std::string Substitute(const CompiledTemplate& strTemplate, size_t idx) const
+    {
+        if(idx >= data.size()) return "";
+        return strTemplate.Render(data[idx]);
+    }
+
     std::string Substitute(std::string_view strTemplate, size_t idx) const
     {
         if(idx >= data.size()) return "";
-        return substitute_template(strTemplate, data[idx]);
+        return CompiledTemplate(strTemplate).Render(data[idx]);
     }
 };
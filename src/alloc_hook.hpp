@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// Counting replacement for the global operator new (alloc_hook.cpp). It is
+// linked into the tests and benchmarks only, never into fxf itself, so
+// allocation budgets of key operations can be asserted and measured.
+
+struct AllocStats {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+// Allocations since process start, over all threads.
+AllocStats CurrentAllocs();
+
+// Counts the allocations made between construction and Delta().
+class AllocationCounter
+{
+public:
+    AllocationCounter() : m_start(CurrentAllocs()) {}
+
+    AllocStats Delta() const
+    {
+        AllocStats now = CurrentAllocs();
+        return {now.count - m_start.count, now.bytes - m_start.bytes};
+    }
+
+    uint64_t Count() const { return Delta().count; }
+
+private:
+    AllocStats m_start;
+};
@@ -1,13 +1,54 @@
 #include "app.hpp"
 #include "registries.hpp"
 #include "utils.hpp"
+#include "unicode.hpp"
+#include "search.hpp"
+#include "perf.hpp"
+#include "memory.hpp"
+#include "fileview.hpp"
 
 #include <ftxui/component/component.hpp>
+#include <ftxui/dom/node.hpp>
 #include <numeric>
-#include <sstream>
 
 using namespace ftxui;
 
+namespace {
+
+// Wraps a frame's root element and, once it has been drawn, records the time
+// since the frame started building: element construction, layout and drawing.
+class FrameTimerNode : public Node
+{
+public:
+    FrameTimerNode(Element child, ScopedTimer::clock::time_point start)
+        : Node(Elements{std::move(child)})
+        , m_start(start)
+    {}
+
+    void ComputeRequirement() override
+    {
+        Node::ComputeRequirement();
+        requirement_ = children_[0]->requirement();
+    }
+
+    void SetBox(Box box) override
+    {
+        Node::SetBox(box);
+        children_[0]->SetBox(box);
+    }
+
+    void Render(Screen& screen) override
+    {
+        Node::Render(screen);
+        RecordSpan(PerfStage::Frame, m_start, ScopedTimer::clock::now());
+    }
+
+private:
+    ScopedTimer::clock::time_point m_start;
+};
+
+}
+
 void App::Load(const std::string& filename, char delimiter)
 {
     state.delimiter = delimiter;
@@ -17,7 +58,9 @@ void App::Load(const std::string& filename, char delimiter)
         return;
     }
     controls.viewTemplate = "{}";
-    ResetFilter();
+    controls.filters.clear();
+    controls.sortSpec.reset();
+    ResetView();
     controls.selected = 0;
 }
 
@@ -93,21 +136,30 @@ void App::CreateGUI()
             menuWithPreview,
             });
     components.commandDialog = this->CreateCommandDialog();
+    components.displayDialog = this->CreateDisplayDialog();
 
-    components.mainContainer = components.baseContainer | Modal(components.commandDialog, &m_commandModalVisible);
+    components.mainContainer = components.baseContainer
+        | Modal(components.commandDialog, &m_commandModalVisible)
+        | Modal(components.displayDialog, &controls.display.isActive);
 
     commands.RegisterDefaultCommands();
     keybinds.RegisterDefaultKeybinds();
 
-    components.mainEventHandler = CatchEvent(components.mainContainer, [this](Event event){
-        // Only dispatch keybinds in Normal mode
-        if(mode != AppMode::Normal)
+    auto eventHandler = CatchEvent(components.mainContainer, [this](Event event){
+        // Only dispatch keybinds in Normal mode, and not while output is shown
+        if(mode != AppMode::Normal || controls.display.isActive)
         {
             return false;
         }
 
         return keybinds.Execute(event);
     });
+
+    components.mainEventHandler = Renderer(eventHandler, [eventHandler]{
+        if (!Perf::Enabled() && !Trace::Enabled()) return eventHandler->Render();
+        auto start = ScopedTimer::clock::now();
+        return Element(std::make_shared<FrameTimerNode>(eventHandler->Render(), start));
+    });
 }
 
 void App::Loop()
@@ -270,6 +322,46 @@ Component App::CreateCommandDialog()
     }) | border ;
 }
 
+Component App::CreateDisplayDialog()
+{
+    auto content = Renderer([this]{
+        const std::string_view output = controls.display.string;
+        int height = std::max(1, Terminal::Size().dimy - 4);
+
+        Elements lines;
+        int lineNo = 0;
+        for (auto line : output | std::views::split('\n')) {
+            if (lineNo >= controls.display.cursorPosition + height) break;
+            if (lineNo++ >= controls.display.cursorPosition) {
+                lines.push_back(text(std::string(line.begin(), line.end())));
+            }
+        }
+        return vbox(std::move(lines));
+    });
+
+    // Scroll with j/k, close with Escape, Enter or q
+    return CatchEvent(content, [this](Event event){
+        if(event == Event::Escape || event == Event::Return || event == Event::q)
+        {
+            controls.display.isActive = false;
+            controls.display.cursorPosition = 0;
+            return true;
+        }
+        if(event == Event::j || event == Event::ArrowDown)
+        {
+            int lastLine = static_cast<int>(std::ranges::count(controls.display.string, '\n'));
+            controls.display.cursorPosition = std::min(controls.display.cursorPosition + 1, lastLine);
+            return true;
+        }
+        if(event == Event::k || event == Event::ArrowUp)
+        {
+            controls.display.cursorPosition = std::max(controls.display.cursorPosition - 1, 0);
+            return true;
+        }
+        return true;   // Modal: swallow everything else
+    }) | border;
+}
+
 Component App::CreateMenu()
 {
     auto menuEntryOption = MenuEntryOption();
@@ -279,9 +371,29 @@ Component App::CreateMenu()
         int menuWidth = controls.preview.isVisible ? termWidth / 2 : termWidth;
         int entryWidth = menuWidth - scrollBarWidth;
         int ellipsesWidth = 3;
-        std::string label = s.label;
-        if(static_cast<int>(label.size()) > entryWidth)
-            label = label.substr(0, entryWidth - ellipsesWidth) + "...";
+
+        EntryLayout scratch;
+        bool cached = s.index >= 0 && static_cast<size_t>(s.index) < controls.menuLayouts.size();
+        EntryLayout& layout = cached ? controls.menuLayouts[s.index] : scratch;
+        if(layout.width < 0)
+            layout.width = static_cast<int>(DisplayWidth(s.label));
+
+        std::string label;
+        if(layout.width > entryWidth)
+        {
+            if(layout.cutForWidth != entryWidth)
+            {
+                layout.cutBytes = CutToWidth(s.label, std::max(0, entryWidth - ellipsesWidth)).bytes;
+                layout.cutForWidth = entryWidth;
+            }
+            label.reserve(layout.cutBytes + ellipsesWidth);
+            label.append(s.label, 0, layout.cutBytes);
+            label += "...";
+        }
+        else
+        {
+            label = s.label;
+        }
 
         bool isMultiSelected = (s.index >= 0) && IsSelected(static_cast<size_t>(s.index));
 
@@ -391,12 +503,23 @@ Component App::CreateStatusBar()
         return text(controls.viewTemplate);
     });
 
+    auto selectionCount = Renderer([&]{
+        size_t count = controls.selections.Count();
+        if (count == 0) return text("");
+        return text(" | " + std::to_string(count) + " selected") | color(Color::Yellow);
+    });
+
     auto debug = Renderer([&]{
         auto divider = state.debug.empty() ? "" : " | "; 
         return text(divider + state.debug);
     });
 
-    auto barTabs = Container::Horizontal({components.searchPrompt, searchInput, currentViewTemplate, debug}) | size(HEIGHT, EQUAL,1);
+    auto perfHud = Renderer([&]{
+        if (!state.perfHud) return text("");
+        return text(" | " + Perf::Summary() + "  " + m_previewPool.Summary()) | color(Color::Cyan);
+    });
+
+    auto barTabs = Container::Horizontal({components.searchPrompt, searchInput, currentViewTemplate, selectionCount, debug, perfHud}) | size(HEIGHT, EQUAL,1);
 
     components.searchInput = searchInput;
     return barTabs;
@@ -413,6 +536,21 @@ void App::ReapplyViewTemplate()
     UpdateFilteredView();
 }
 
+const CompiledTemplate& App::CompiledViewTemplate()
+{
+    // viewTemplate is assigned directly in a few places; recompile lazily on change.
+    if (cache.viewTemplate.Source() != controls.viewTemplate) {
+        cache.viewTemplate = CompiledTemplate(controls.viewTemplate);
+    }
+    return cache.viewTemplate;
+}
+
+void App::BuildSearchLabels()
+{
+    cache.menuEntries = state.lines.GetMenuEntries(CompiledViewTemplate());
+    cache.menuEntriesGeneration = state.lines.generation;
+}
+
 std::optional<size_t> App::GetOriginalIndex(size_t displayIndex) const
 {
     if (displayIndex >= controls.filteredIndices.size()) return std::nullopt;
@@ -423,101 +561,288 @@ bool App::IsSelected(size_t displayIndex) const
 {
     auto origIdx = GetOriginalIndex(displayIndex);
     if (!origIdx) return false;
-    return controls.selections.contains(*origIdx);
+    return controls.selections.Test(*origIdx);
 }
 
 void App::ToggleSelection(size_t displayIndex)
 {
     auto origIdx = GetOriginalIndex(displayIndex);
     if (!origIdx) return;
-    if (controls.selections.contains(*origIdx)) {
-        controls.selections.erase(*origIdx);
-    } else {
-        controls.selections.insert(*origIdx);
-    }
+    controls.selections.Flip(*origIdx);
 }
 
 void App::ClearSelections()
 {
-    controls.selections.clear();
+    controls.selections.Clear();
 }
 
 void App::SelectAll()
 {
+    // filteredIndices holds distinct rows, so covering the row count means every row.
+    size_t rowCount = state.lines.data.size();
+    if (controls.filteredIndices.size() == rowCount) {
+        controls.selections.Resize(rowCount);
+        controls.selections.SetAll();
+        return;
+    }
     for (size_t origIdx : controls.filteredIndices) {
-        controls.selections.insert(origIdx);
+        controls.selections.Set(origIdx);
     }
 }
 
 void App::InvertSelections()
 {
+    size_t rowCount = state.lines.data.size();
+    if (controls.filteredIndices.size() == rowCount) {
+        controls.selections.Resize(rowCount);
+        controls.selections.FlipAll();
+        return;
+    }
     for (size_t origIdx : controls.filteredIndices) {
-        if (controls.selections.contains(origIdx)) {
-            controls.selections.erase(origIdx);
-        } else {
-            controls.selections.insert(origIdx);
-        }
+        controls.selections.Flip(origIdx);
     }
 }
 
 void App::UpdateFilteredView()
 {
-    controls.menuEntries.clear();
-    controls.menuEntries.reserve(controls.filteredIndices.size());
-    for (size_t origIdx : controls.filteredIndices) {
-        controls.menuEntries.push_back(
-            substitute_template(controls.viewTemplate, state.lines[origIdx])
-        );
+    ScopedTimer timer(PerfStage::View);
+    const CompiledTemplate& viewTemplate = CompiledViewTemplate();
+    auto& labels = controls.menuEntries.Owned(controls.filteredIndices.size());
+    for (size_t i = 0; i < labels.size(); ++i) {
+        labels[i].clear();
+        viewTemplate.RenderInto(labels[i], state.lines[controls.filteredIndices[i]]);
     }
+    controls.menuLayouts.assign(labels.size(), EntryLayout{});
 }
 
 void App::RefreshFilteredView()
 {
-    controls.menuEntries.clear();
-    controls.menuEntries.reserve(controls.filteredIndices.size());
-    // TODO: perhaps just copy + re-sort?
-    for (size_t origIdx : controls.filteredIndices) {
-        controls.menuEntries.push_back(
-            cache.menuEntries[origIdx]
-        );
+    // The search labels are current only if built from this exact table state
+    // (not just one with as many rows); otherwise render.
+    if (cache.menuEntriesGeneration != state.lines.generation) {
+        UpdateFilteredView();
+        return;
     }
+
+    // Show the search labels through filteredIndices without copying them.
+    ScopedTimer timer(PerfStage::View);
+    controls.menuEntries.Index(cache.menuEntries, controls.filteredIndices);
+    controls.menuLayouts.assign(controls.filteredIndices.size(), EntryLayout{});
 }
 
 void App::ResetFilter()
 {
-    controls.filteredIndices.clear();
-    controls.filteredIndices.reserve(state.lines.data.size());
-    for (size_t i = 0; i < state.lines.data.size(); ++i) {
-        controls.filteredIndices.push_back(i);
-    }
+    controls.filteredIndices = controls.baseIndices;
     UpdateFilteredView();
 }
 
+void App::ResetView()
+{
+    controls.baseIndices.resize(state.lines.data.size());
+    std::iota(controls.baseIndices.begin(), controls.baseIndices.end(), 0);
+    for (const Predicate& predicate : controls.filters) {
+        controls.baseIndices = FilterIndices(state.lines, state.columns, controls.baseIndices, predicate);
+    }
+    if (controls.sortSpec) {
+        SortIndices(state.lines, state.columns, controls.baseIndices, *controls.sortSpec);
+    }
+    ResetFilter();
+}
+
 void App::UpdateSearch()
 {
-    screen.Post([&]{
-        if (controls.searchDialog.string.empty()) {
-            ResetFilter();
-            controls.selected = 0;
-            return;
-        }
+    screen.Post([this]{ ApplySearch(); });
+}
+
+void App::ApplySearch()
+{
+    ScopedTimer timer(PerfStage::Search, "generation", ++m_searchGeneration);
+
+    // Runs on every keystroke. Indices and scoring buffers are reused and the
+    // menu shows cache.menuEntries through filteredIndices, so once warmed up
+    // nothing here allocates per row. Labels built before the rows last changed
+    // are rebuilt first.
+    if (cache.menuEntriesGeneration != state.lines.generation) {
+        BuildSearchLabels();
+    }
+    if (controls.searchDialog.string.empty()) {
+        controls.filteredIndices.assign(controls.baseIndices.begin(), controls.baseIndices.end());
+    } else {
+        // Rank only the rows in the base view, so `where` filters compose with search.
+        RankMatchesInto(controls.searchDialog.string, cache.menuEntries, controls.baseIndices,
+                        controls.filteredIndices, m_rankScratch);
+    }
+    RefreshFilteredView();
+    controls.selected = 0;
 
-        auto fuzzyResults = extract(controls.searchDialog.string, cache.menuEntries);
+    // Rows moved under the cursor, so prefetched neighbours are stale.
+    m_previewPool.CancelPrefetch();
+    m_previewPosition = -1;
+}
 
-        // Sort by score descending
-        std::ranges::sort(fuzzyResults, std::ranges::greater{}, [](const auto& p) {
-            return p.second;
-        });
+void App::SortView(const SortSpec& spec)
+{
+    // Sorting the base order keeps it once the search is cleared.
+    controls.sortSpec = spec;
+    SortIndices(state.lines, state.columns, controls.baseIndices, spec);
+    SortIndices(state.lines, state.columns, controls.filteredIndices, spec);
+    UpdateFilteredView();
+    controls.selected = 0;
+    UpdatePreviewIfNeeded();
+}
+
+void App::FilterView(const Predicate& predicate)
+{
+    controls.filters.push_back(predicate);
+    controls.baseIndices = FilterIndices(state.lines, state.columns, controls.baseIndices, predicate);
+    controls.filteredIndices = FilterIndices(state.lines, state.columns, controls.filteredIndices, predicate);
+    UpdateFilteredView();
+    controls.selected = 0;
+    UpdatePreviewIfNeeded();
+}
+
+void App::ClearViewFilters()
+{
+    controls.filters.clear();
+    ResetView();
+    if (!controls.searchDialog.string.empty()) {
+        UpdateSearch();
+    }
+    controls.selected = 0;
+    UpdatePreviewIfNeeded();
+}
+
+void App::ShowGroups(const GroupSpec& spec)
+{
+    CloseGroups();
+
+    auto groups = GroupIndices(state.lines, state.columns, controls.filteredIndices, spec);
+    RowTable table = GroupsToRowTable(groups, spec.valueColumn.has_value());
+
+    groupView.isActive = true;
+    groupView.members.clear();
+    groupView.members.reserve(groups.size());
+    for (Group& group : groups) {
+        groupView.members.push_back(std::move(group.members));
+    }
+
+    groupView.lines = std::exchange(state.lines, std::move(table));
+    groupView.selections = std::exchange(controls.selections, {});
+    groupView.viewTemplate = std::exchange(controls.viewTemplate, "{}");
+    groupView.filters = std::exchange(controls.filters, {});
+    groupView.sortSpec = std::exchange(controls.sortSpec, std::nullopt);
+    groupView.baseIndices = controls.baseIndices;
+    groupView.filteredIndices = controls.filteredIndices;
+
+    // The search ranked rows of the grouped table, not groups. It comes back
+    // with filteredIndices on ungroup.
+    groupView.search = std::exchange(controls.searchDialog.string, {});
+    controls.searchDialog.cursorPosition = 0;
+
+    ResetView();
+    controls.selected = 0;
+    UpdatePreviewIfNeeded();
+}
+
+bool App::DrillDownGroup(size_t displayIndex)
+{
+    if (!groupView.isActive) return false;
 
-        // Extract indices in sorted order
-        controls.filteredIndices.clear();
-        controls.filteredIndices.reserve(fuzzyResults.size());
-        for (const auto& [idx, score] : fuzzyResults) {
-            controls.filteredIndices.push_back(idx);
+    std::vector<size_t> rows;
+    if (controls.selections.None()) {
+        auto origIdx = GetOriginalIndex(displayIndex);
+        if (!origIdx || *origIdx >= groupView.members.size()) return false;
+        rows = std::move(groupView.members[*origIdx]);
+    } else {
+        // Several groups: keep their members in the order of the grouped view.
+        DynamicBitset marked;
+        controls.selections.ForEachSet([&](size_t group) {
+            if (group >= groupView.members.size()) return;
+            for (size_t row : groupView.members[group]) marked.Set(row);
+        });
+        for (size_t row : groupView.filteredIndices) {
+            if (marked.Test(row)) rows.push_back(row);
         }
-        RefreshFilteredView();
-        controls.selected = 0;
-    });
+    }
+
+    RestoreGroupedTable();
+    controls.baseIndices = rows;
+    controls.filteredIndices = std::move(rows);
+    UpdateFilteredView();
+    controls.selected = 0;
+    UpdatePreviewIfNeeded();
+    return true;
+}
+
+bool App::CloseGroups()
+{
+    if (!groupView.isActive) return false;
+
+    RestoreGroupedTable();
+    controls.baseIndices = std::move(groupView.baseIndices);
+    controls.filteredIndices = std::move(groupView.filteredIndices);
+    controls.searchDialog.string = std::move(groupView.search);
+    controls.searchDialog.cursorPosition = static_cast<int>(controls.searchDialog.string.size());
+    UpdateFilteredView();
+    controls.selected = 0;
+    UpdatePreviewIfNeeded();
+    return true;
+}
+
+void App::RestoreGroupedTable()
+{
+    state.lines = std::move(groupView.lines);
+    controls.selections = std::move(groupView.selections);
+    controls.viewTemplate = std::move(groupView.viewTemplate);
+    controls.filters = std::move(groupView.filters);
+    controls.sortSpec = std::move(groupView.sortSpec);
+    controls.searchDialog.string.clear();
+    controls.searchDialog.cursorPosition = 0;
+    groupView.members.clear();
+    groupView.isActive = false;
+}
+
+std::vector<MemoryEntry> App::MemoryUsage() const
+{
+    const auto& preview = controls.preview;
+    std::vector<MemoryEntry> entries = {
+        {"rows", state.lines.data.size(), HeapBytes(state.lines)},
+        {"row fields", FieldCount(state.lines), 0},
+        {"column cache", state.columns.ColumnCount(), state.columns.HeapBytes()},
+        {"menu entries", controls.menuEntries.size(), HeapBytes(controls.menuEntries.OwnedLabels())},
+        {"menu layouts", controls.menuLayouts.size(), HeapBytes(controls.menuLayouts)},
+        {"search labels", cache.menuEntries.size(), HeapBytes(cache.menuEntries)},
+        {"base indices", controls.baseIndices.size(), HeapBytes(controls.baseIndices)},
+        {"filtered indices", controls.filteredIndices.size(), HeapBytes(controls.filteredIndices)},
+        {"selections", controls.selections.Count(), controls.selections.HeapBytes()},
+        {"preview", preview.lineStarts.size(), HeapBytes(preview.content) + HeapBytes(preview.lineStarts)},
+        {"preview cache", scope.CacheEntries(), scope.CacheBytes()},
+        {"line indexes", scope.LineIndexes().Size(), scope.LineIndexes().HeapBytes()},
+    };
+
+    if (const DiskCache* disk = scope.DiskStore()) {
+        entries.push_back({"disk cache index", disk->Entries(), disk->HeapBytes()});
+    }
+
+    if (groupView.isActive) {
+        size_t memberBytes = groupView.members.capacity() * sizeof(groupView.members[0]);
+        for (const auto& members : groupView.members) memberBytes += HeapBytes(members);
+        entries.push_back({"group members", groupView.members.size(), memberBytes});
+        entries.push_back({"ungrouped rows", groupView.lines.data.size(), HeapBytes(groupView.lines)});
+    }
+    return entries;
+}
+
+std::string App::MemoryReport() const
+{
+    return FormatMemoryReport(MemoryUsage());
+}
+
+void App::SetPerfHud(bool visible)
+{
+    // Timers only run while the HUD is up, so a hidden HUD costs nothing.
+    state.perfHud = visible;
+    Perf::SetEnabled(visible);
 }
 
 void App::TogglePreview()
@@ -525,38 +850,139 @@ void App::TogglePreview()
     controls.preview.isVisible = !controls.preview.isVisible;
     if (controls.preview.isVisible) {
         UpdatePreview();
+    } else {
+        m_previewPool.Cancel();
+        m_previewPosition = -1;
     }
 }
 
-void App::UpdatePreview()
+void App::UpdatePreview(bool refresh)
 {
     if (!controls.preview.isVisible) return;
 
-    controls.preview.content = "Loading...";
-    controls.preview.scrollPosition = 0;
-
     auto maybeIdx = GetOriginalIndex(static_cast<size_t>(controls.selected));
     if (!maybeIdx) {
-        controls.preview.content = "No item selected";
+        SetPreviewContent("No item selected");
         return;
     }
 
-    std::string entry = state.lines.GetJoinedRow(*maybeIdx);
+    // Steady j/k scrolling prefetches the rows ahead; anything else is a jump
+    // that makes queued and running prefetches pointless. The prefetch is
+    // queued after the request below, so idle workers pick the request first
+    // instead of starting prefetches that Submit would then stop.
+    int step = controls.selected - m_previewPosition;
+    m_previewPosition = controls.selected;
+    const bool sequential = step == 1 || step == -1;
+    if (!sequential) {
+        m_previewPool.CancelPrefetch();
+    }
+
+    const bool byCommand = PreviewsByCommand();
+    std::string entry = PreviewSource(*maybeIdx);
     size_t requestId = ++m_previewRequestId;
+    controls.preview.lastProcessedIndex = *maybeIdx;
+
+    // Prefetched or seen before: show it without a round trip to the pool.
+    auto cached = refresh ? nullptr : byCommand ? scope.CachedCommand(entry) : scope.Cached(entry);
+    if (cached) {
+        m_previewPool.CancelRequest();
+        SetPreviewContent(*cached);
+        if (sequential) PrefetchPreviews(controls.selected, step);
+        return;
+    }
+
+    SetPreviewContent("Loading...");
+    controls.preview.loading = true;
+
+    // Supersedes the previous request: if it has not started it never will,
+    // and if it is running it is stopped along with any helper processes.
+    const size_t lineBudget = PreviewLineBudget();
+    m_previewPool.Submit([this, entry = std::move(entry), byCommand, requestId, refresh, lineBudget](std::stop_token stop) {
+        if (Trace::Enabled()) Trace::SetThreadName("preview");
+        Trace::AsyncBegin("preview request", requestId);
+
+        // Output of slow renders is shown as it arrives; reading stops once
+        // there is more than the pane can show or scroll to.
+        size_t lines = 0;
+        auto onOutput = [this, requestId, lineBudget, &lines](std::string_view chunk) {
+            lines += CountNewlines(chunk.data(), chunk.size());
+            screen.Post([this, chunk = std::string(chunk), requestId] {
+                if (requestId == m_previewRequestId) {
+                    AppendPreviewContent(chunk);
+                }
+            });
+            screen.PostEvent(Event::Custom);
+            return lines < lineBudget;
+        };
 
-    m_previewFuture = std::async(std::launch::async, [this, entry, requestId]() -> std::string {
-        std::string result = scope.Process(entry);
-        screen.Post([this, result, requestId]{
+        std::string result = RenderPreview(entry, byCommand, stop, refresh, onOutput);
+        if (stop.stop_requested()) {
+            Trace::AsyncEnd("preview request", requestId);
+            return;
+        }
+        screen.Post([this, result = std::move(result), requestId]() mutable {
             if (requestId == m_previewRequestId) {
-                controls.preview.content = result;
+                // Streamed output is already on screen; keep the reader's place in it.
+                int scroll = controls.preview.loading ? 0 : controls.preview.scrollPosition;
+                SetPreviewContent(std::move(result));
+                int lastLine = std::max(0, static_cast<int>(controls.preview.lineStarts.size()) - 1);
+                controls.preview.scrollPosition = std::min(scroll, lastLine);
             }
+            Trace::AsyncEnd("preview request", requestId);
         });
         // Trigger a screen redraw after content is updated
         screen.PostEvent(Event::Custom);
-        return result;
     });
+    if (sequential) PrefetchPreviews(controls.selected, step);
+}
 
-    controls.preview.lastProcessedIndex = *maybeIdx;
+void App::PrefetchPreviews(int position, int step)
+{
+    // Rows the cursor is heading for, nearest first, then one row behind it.
+    constexpr int kAhead = 3;
+    constexpr int kBehind = 1;
+
+    const bool byCommand = PreviewsByCommand();
+    std::vector<PreviewPool::Job> jobs;
+    auto add = [&](int offset) {
+        if (position + offset < 0) return;
+        auto maybeIdx = GetOriginalIndex(static_cast<size_t>(position + offset));
+        if (!maybeIdx) return;
+        std::string entry = PreviewSource(*maybeIdx);
+        if (byCommand ? scope.CachedCommand(entry) : scope.Cached(entry)) return;
+        jobs.push_back([this, entry = std::move(entry), byCommand](std::stop_token stop) {
+            if (Trace::Enabled()) Trace::SetThreadName("preview");
+            TraceSpan span("preview prefetch");
+            RenderPreview(entry, byCommand, stop);
+        });
+    };
+    for (int i = 1; i <= kAhead; ++i) add(i * step);
+    for (int i = 1; i <= kBehind; ++i) add(-i * step);
+
+    m_previewPool.Prefetch(std::move(jobs));
+}
+
+std::string App::RenderPreview(const std::string& source, bool byCommand, std::stop_token stop,
+                               bool refresh, const PreviewSink& onOutput)
+{
+    return byCommand ? scope.ProcessCommand(source, stop, refresh, onOutput)
+                     : scope.Process(source, stop, refresh, onOutput);
+}
+
+bool App::PreviewsByCommand() const
+{
+    return !controls.previewCommand.empty() || scope.PreviewHelper() != nullptr;
+}
+
+std::string App::PreviewSource(size_t originalIndex)
+{
+    if (controls.previewCommand.empty()) {
+        return state.lines.GetJoinedRow(originalIndex);
+    }
+    if (cache.previewCommand.Source() != controls.previewCommand) {
+        cache.previewCommand = CompiledTemplate(controls.previewCommand);
+    }
+    return state.lines.Substitute(cache.previewCommand, originalIndex);
 }
 
 void App::UpdatePreviewIfNeeded()
@@ -571,6 +997,44 @@ void App::UpdatePreviewIfNeeded()
     }
 }
 
+void App::SetPreviewContent(std::string content)
+{
+    // Split once here so the renderer only slices the visible lines per frame.
+    controls.preview.content = std::move(content);
+    controls.preview.lineStarts = IndexLines(controls.preview.content);
+    controls.preview.loading = false;
+    controls.preview.scrollPosition = 0;
+}
+
+void App::AppendPreviewContent(std::string_view chunk)
+{
+    auto& preview = controls.preview;
+    if (preview.loading) {
+        preview.content.clear();
+        preview.lineStarts.clear();
+        preview.loading = false;
+    }
+
+    // Only the new bytes are indexed, so streaming stays linear in the output.
+    size_t from = preview.content.size();
+    preview.content.append(chunk);
+    ExtendLineIndex(preview.lineStarts, preview.content, from);
+}
+
+int App::PreviewPaneHeight() const
+{
+    // Height of the pane on the previous frame; the whole terminal before the first one.
+    int height = components.previewBox.y_max - components.previewBox.y_min + 1;
+    return height > 0 ? height : Terminal::Size().dimy;
+}
+
+size_t App::PreviewLineBudget() const
+{
+    // Lines past the first screen a reader can scroll through
+    constexpr size_t kScrollLines = 1000;
+    return static_cast<size_t>(PreviewPaneHeight()) + kScrollLines;
+}
+
 void App::ScrollPreviewUp()
 {
     if (controls.preview.scrollPosition > 0) {
@@ -580,36 +1044,47 @@ void App::ScrollPreviewUp()
 
 void App::ScrollPreviewDown()
 {
-    controls.preview.scrollPosition++;
+    int lastLine = static_cast<int>(controls.preview.lineStarts.size()) - 1;
+    if (controls.preview.scrollPosition < lastLine) {
+        controls.preview.scrollPosition++;
+    }
 }
 
 Component App::CreatePreviewPane()
 {
     return Renderer([this]{
-        if (controls.preview.content.empty()) {
+        const auto& preview = controls.preview;
+        if (preview.content.empty()) {
             return window(text(" Preview "), text("No preview") | dim | center) | flex;
         }
 
-        Elements lines;
-        std::istringstream iss(controls.preview.content);
-        std::string line;
-        while (std::getline(iss, line)) {
-            lines.push_back(text(line));
-        }
+        int height = PreviewPaneHeight();
 
-        // Apply scroll offset
-        int scrollOffset = controls.preview.scrollPosition;
-        int totalLines = static_cast<int>(lines.size());
-        int visibleStart = std::min(scrollOffset, std::max(0, totalLines - 1));
+        int totalLines = static_cast<int>(preview.lineStarts.size());
+        int visibleStart = std::clamp(preview.scrollPosition, 0, std::max(0, totalLines - 1));
+        int visibleEnd = std::min(totalLines, visibleStart + height);
 
+        const std::string_view content = preview.content;
         Elements visibleLines;
-        for (int i = visibleStart; i < totalLines; ++i) {
-            visibleLines.push_back(std::move(lines[i]));
+        visibleLines.reserve(visibleEnd - visibleStart);
+        for (int i = visibleStart; i < visibleEnd; ++i) {
+            size_t begin = preview.lineStarts[i];
+            size_t end = (i + 1 < totalLines) ? preview.lineStarts[i + 1] - 1 : content.size();
+            if (end > begin && content[end - 1] == '\n') {
+                --end;
+            }
+            visibleLines.push_back(text(std::string{content.substr(begin, end - begin)}));
+        }
+
+        std::string title = " Preview ";
+        if (totalLines > height) {
+            title += std::to_string(visibleStart + 1) + "-" + std::to_string(visibleEnd)
+                   + "/" + std::to_string(totalLines) + " ";
         }
 
         return window(
-            text(" Preview "),
-            vbox(std::move(visibleLines)) | vscroll_indicator | frame | flex
+            text(title),
+            vbox(std::move(visibleLines)) | yflex | reflect(components.previewBox)
         ) | flex;
     });
 }
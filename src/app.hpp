@@ -4,13 +4,18 @@
 #include <ftxui/screen/box.hpp>
 
 #include <optional>
-#include <set>
-#include <future>
 #include <atomic>
 
 #include "RowTable.hpp"
+#include "bitset.hpp"
+#include "columns.hpp"
+#include "memory.hpp"
+#include "menu_entries.hpp"
+#include "preview_pool.hpp"
+#include "query.hpp"
 #include "registries.hpp"
 #include "scope.hpp"
+#include "search.hpp"
 
 // Application mode state machine
 enum class AppMode {
@@ -33,22 +38,35 @@ public:
 
     struct State {
         RowTable lines;
+        ColumnCache columns;                  // Parsed column data for sort/where
         char delimiter = '|';
         std::string debug = "";
+        bool perfHud = false;                 // Show per-stage latency next to debug
         std::string output = "";
     };
 
     struct PreviewState {
         bool isVisible = false;
         std::string content = "";
+        std::vector<size_t> lineStarts;   // Line index into content, see SetPreviewContent
+        bool loading = false;             // content is a placeholder until the first output arrives
         size_t lastProcessedIndex = SIZE_MAX;
         int scrollPosition = 0;
     };
 
+    // Display width of a menu label and where to cut it, computed on first render
+    struct EntryLayout {
+        int width = -1;          // Display width of the label, -1 until measured
+        int cutForWidth = -1;    // Entry width cutBytes was computed for
+        size_t cutBytes = 0;     // Label prefix shown before the ellipsis
+    };
+
     struct Controls {
-        std::vector<std::string> menuEntries;
+        MenuEntries menuEntries;              // Labels by display position
+        std::vector<EntryLayout> menuLayouts; // Parallel to menuEntries
+        std::vector<size_t> baseIndices;      // Rows passing `where` filters, in sort order; search ranks within these
         std::vector<size_t> filteredIndices;  // Maps display position -> original index
-        std::set<size_t> selections;          // Selected original indices
+        DynamicBitset selections;             // Selected original indices
         int selected = 0;
         int focused = 0;
         ControlHandle commandDialog;
@@ -56,11 +74,31 @@ public:
         ControlHandle searchDialog;
         std::string viewTemplate = "{}";
         std::string searchPrompt = "> ";
+        std::string previewCommand;           // Template rendering a row's preview; empty: by content type
         PreviewState preview;
+        std::vector<Predicate> filters;       // Active `where` clauses, all must match
+        std::optional<SortSpec> sortSpec;     // Active `sort`
     };
 
     struct Cache {
         std::vector<std::string> menuEntries;
+        uint64_t menuEntriesGeneration = 0;   // state.lines.generation menuEntries were built from
+        CompiledTemplate viewTemplate;        // Compiled form of controls.viewTemplate
+        CompiledTemplate previewCommand;      // Compiled form of controls.previewCommand
+    };
+
+    // Set while a `group` result replaces the table; holds what to restore on exit
+    struct GroupView {
+        bool isActive = false;
+        std::vector<std::vector<size_t>> members;   // Original row ids per group row
+        RowTable lines;
+        DynamicBitset selections;
+        std::string viewTemplate;
+        std::vector<Predicate> filters;
+        std::optional<SortSpec> sortSpec;
+        std::vector<size_t> baseIndices;
+        std::vector<size_t> filteredIndices;
+        std::string search;                          // Query that produced filteredIndices
     };
 
     struct ComponentChildren {
@@ -69,11 +107,13 @@ public:
         ftxui::Component baseContainer{nullptr};
         ftxui::Component mainContainer{nullptr};
         ftxui::Component commandDialog{nullptr};
+        ftxui::Component displayDialog{nullptr};
         ftxui::Component mainEventHandler{nullptr};
         ftxui::Component searchInput{nullptr};
         ftxui::Component searchPrompt{nullptr};
         ftxui::Component previewPane{nullptr};
         ftxui::Box menuBox;
+        ftxui::Box previewBox;
     }; 
 
 public:
@@ -98,6 +138,8 @@ public:
     void FocusSearch();
     void ApplyViewTemplate(std::string_view viewTemplate);
     void ReapplyViewTemplate();
+    const CompiledTemplate& CompiledViewTemplate();
+    void BuildSearchLabels();
 
     // Index and selection helpers
     std::optional<size_t> GetOriginalIndex(size_t displayIndex) const;
@@ -109,25 +151,64 @@ public:
     void UpdateFilteredView();
     void RefreshFilteredView();
     void ResetFilter();
-    void UpdateSearch();
+    void ResetView();
+    void UpdateSearch();                  // Queues ApplySearch on the UI thread
+    void ApplySearch();                   // Ranks rows against the search string
+    void SortView(const SortSpec& spec);
+    void FilterView(const Predicate& predicate);
+    void ClearViewFilters();
+
+    // Group view
+    void ShowGroups(const GroupSpec& spec);
+    bool DrillDownGroup(size_t displayIndex);
+    bool CloseGroups();
+
+    // Per-subsystem heap usage, and the same as a printable table
+    std::vector<MemoryEntry> MemoryUsage() const;
+    std::string MemoryReport() const;
+
+    // Show or hide the latency HUD; also turns the perf timers on or off
+    void SetPerfHud(bool visible);
 
     // Preview methods
     void TogglePreview();
-    void UpdatePreview();
+    void UpdatePreview(bool refresh = false);   // refresh: re-render, bypassing the caches
     void UpdatePreviewIfNeeded();
+    void SetPreviewContent(std::string content);
+    void AppendPreviewContent(std::string_view chunk);   // Streamed output; replaces the placeholder
+    int PreviewPaneHeight() const;                       // Rows of text on the last frame
+    size_t PreviewLineBudget() const;                    // Lines worth streaming: pane height plus scrolling
     void ScrollPreviewUp();
     void ScrollPreviewDown();
+    PreviewPool& PreviewWorkers() { return m_previewPool; }
+
+    // Previews come from a command (controls.previewCommand, or the row text
+    // sent to scope's preview helper) rather than from the row's content type.
+    bool PreviewsByCommand() const;
+    // The row's preview command with its fields substituted, or its text
+    std::string PreviewSource(size_t originalIndex);
 
 private:
     ftxui::Component CreateMenu();
     ftxui::Component CreateStatusBar();
     ftxui::Component CreateCommandDialog();
+    ftxui::Component CreateDisplayDialog();
     ftxui::Component CreatePreviewPane();
     static bool HandleReadlineEvent(const ftxui::Event& event, std::string& str, int& cursor);
+    void RestoreGroupedTable();
 
-    // Async preview state
-    std::future<std::string> m_previewFuture;
+    // Async preview state. Declared after scope and screen, which its jobs
+    // use, so the workers are joined first.
+    PreviewPool m_previewPool;
     std::atomic<size_t> m_previewRequestId{0};
+    int m_previewPosition = -1;   // Display position last previewed, -1 after a jump
+    void PrefetchPreviews(int position, int step);
+    std::string RenderPreview(const std::string& source, bool byCommand, std::stop_token stop,
+                              bool refresh = false, const PreviewSink& onOutput = {});
+
+    // Numbers search updates for the trace
+    uint64_t m_searchGeneration = 0;
+    RankScratch m_rankScratch;
 
     // Modal visibility for FTXUI Modal() operator
     bool m_commandModalVisible = false;
@@ -136,6 +217,7 @@ public:
     State state;
     Controls controls;
     Cache cache;
+    GroupView groupView;
 
 private:
     ComponentChildren components;
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Word-packed set of row ids. Bulk operations work 64 bits at a time.
+class DynamicBitset
+{
+public:
+    using word_t = uint64_t;
+    static constexpr size_t kWordBits = 64;
+
+    size_t Size() const { return m_size; }
+
+    // Grows with cleared bits; shrinking drops bits at or beyond newSize.
+    void Resize(size_t newSize)
+    {
+        m_words.resize(WordCount(newSize), 0);
+        m_size = newSize;
+        MaskTail();
+    }
+
+    bool Test(size_t pos) const
+    {
+        if (pos >= m_size) return false;
+        return (m_words[pos / kWordBits] >> (pos % kWordBits)) & 1;
+    }
+
+    void Set(size_t pos)
+    {
+        if (pos >= m_size) Resize(pos + 1);
+        m_words[pos / kWordBits] |= Bit(pos);
+    }
+
+    void Reset(size_t pos)
+    {
+        if (pos >= m_size) return;
+        m_words[pos / kWordBits] &= ~Bit(pos);
+    }
+
+    void Flip(size_t pos)
+    {
+        if (pos >= m_size) Resize(pos + 1);
+        m_words[pos / kWordBits] ^= Bit(pos);
+    }
+
+    void SetAll()
+    {
+        std::ranges::fill(m_words, ~word_t{0});
+        MaskTail();
+    }
+
+    void FlipAll()
+    {
+        for (word_t& word : m_words) word = ~word;
+        MaskTail();
+    }
+
+    // Clears every bit; the size is kept.
+    void Clear() { std::ranges::fill(m_words, 0); }
+
+    bool None() const { return std::ranges::all_of(m_words, [](word_t w) { return w == 0; }); }
+    bool Any() const { return !None(); }
+
+    size_t Count() const
+    {
+        size_t count = 0;
+        for (word_t word : m_words) count += std::popcount(word);
+        return count;
+    }
+
+    size_t HeapBytes() const { return m_words.capacity() * sizeof(word_t); }
+
+    // Removes bit `pos` and moves every higher bit down by one, as when a row is erased.
+    void EraseAndShift(size_t pos)
+    {
+        if (pos >= m_size) return;
+
+        size_t wordIdx = pos / kWordBits;
+        size_t bitIdx = pos % kWordBits;
+        word_t& first = m_words[wordIdx];
+        word_t low = first & (Bit(pos) - 1);
+        word_t high = bitIdx + 1 < kWordBits ? (first >> (bitIdx + 1)) << bitIdx : 0;
+        first = low | high;
+
+        for (size_t i = wordIdx + 1; i < m_words.size(); ++i) {
+            m_words[i - 1] |= m_words[i] << (kWordBits - 1);
+            m_words[i] >>= 1;
+        }
+        Resize(m_size - 1);
+    }
+
+    // Calls fn(pos) for every set bit in ascending order.
+    template <typename Fn>
+    void ForEachSet(Fn&& fn) const
+    {
+        for (size_t i = 0; i < m_words.size(); ++i) {
+            for (word_t word = m_words[i]; word != 0; word &= word - 1) {
+                fn(i * kWordBits + std::countr_zero(word));
+            }
+        }
+    }
+
+private:
+    static size_t WordCount(size_t bits) { return (bits + kWordBits - 1) / kWordBits; }
+    static word_t Bit(size_t pos) { return word_t{1} << (pos % kWordBits); }
+
+    void MaskTail()
+    {
+        if (size_t tail = m_size % kWordBits; tail != 0) {
+            m_words.back() &= (word_t{1} << tail) - 1;
+        }
+    }
+
+    std::vector<word_t> m_words;
+    size_t m_size = 0;
+};
@@ -0,0 +1,59 @@
+#include "columns.hpp"
+#include "parallel.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+bool ParseNumber(std::string_view text, double& value)
+{
+    const auto first = text.find_first_not_of(" \t");
+    if (first == std::string_view::npos) return false;
+    const auto last = text.find_last_not_of(" \t");
+    text = text.substr(first, last - first + 1);
+
+    if (text.front() == '+') text.remove_prefix(1);
+    if (text.empty()) return false;
+
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc{} && ptr == text.data() + text.size() && !std::isnan(value);
+}
+
+const NumericColumn& ColumnCache::Numeric(const RowTable& table, size_t column)
+{
+    if (m_generation != table.generation) {
+        Clear();
+        m_generation = table.generation;
+    }
+
+    if (auto it = m_numeric.find(column); it != m_numeric.end()) {
+        return it->second;
+    }
+
+    NumericColumn parsed;
+    parsed.values.resize(table.data.size());
+    ParallelFor(table.data.size(), 1 << 14, [&](size_t begin, size_t end, size_t) {
+        constexpr double missing = std::numeric_limits<double>::quiet_NaN();
+        for (size_t i = begin; i < end; ++i) {
+            const auto& row = table.data[i];
+            double value;
+            parsed.values[i] = (column < row.size() && ParseNumber(row[column], value)) ? value : missing;
+        }
+    });
+
+    return m_numeric.emplace(column, std::move(parsed)).first->second;
+}
+
+void ColumnCache::Clear()
+{
+    m_numeric.clear();
+}
+
+size_t ColumnCache::HeapBytes() const
+{
+    size_t bytes = m_numeric.bucket_count() * sizeof(void*);
+    for (const auto& [column, parsed] : m_numeric) {
+        bytes += sizeof(std::pair<const size_t, NumericColumn>) + parsed.values.capacity() * sizeof(double);
+    }
+    return bytes;
+}
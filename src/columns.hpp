@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "RowTable.hpp"
+
+// Parses a whole field (surrounding whitespace allowed) as a number.
+bool ParseNumber(std::string_view text, double& value);
+
+// A column's fields parsed as numbers, stored contiguously by row index.
+struct NumericColumn {
+    std::vector<double> values;   // NaN where the field is missing or not numeric
+};
+
+// Typed views of RowTable columns, built on first use and reused until the
+// table's generation changes.
+class ColumnCache
+{
+public:
+    const NumericColumn& Numeric(const RowTable& table, size_t column);
+    void Clear();
+
+    size_t ColumnCount() const { return m_numeric.size(); }
+    size_t HeapBytes() const;
+
+private:
+    uint64_t m_generation = 0;
+    std::unordered_map<size_t, NumericColumn> m_numeric;
+};
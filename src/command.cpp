@@ -1,6 +1,14 @@
 #include "command.hpp"
 #include "app.hpp"
 #include "utils.hpp"
+#include "process.hpp"
+
+namespace {
+
+// Output shown in the modal display is cut off past this size.
+constexpr size_t kModalOutputLimit = 16 * 1024 * 1024;
+
+}
 
 /* static */
 const Command Command::Null([](std::vector<std::string>){return false;});
@@ -8,15 +16,21 @@ const Command Command::Null([](std::vector<std::string>){return false;});
 bool Command::Execute(std::string_view extraArgs /*= ""*/) const {
     std::string command = m_command + ' '  + std::string{extraArgs};
 
-    auto& app = App::Instance();
-    auto commandstr = app.state.lines.Substitute(command, app.controls.selected);
-
     if(m_nativeCommandExecutor)
     {
         auto args = SplitCommand(command);
         return m_nativeCommandExecutor(args);
     }
 
+    // Placeholders refer to the row under the cursor, which sort, where and
+    // search move away from its position in the table.
+    auto& app = App::Instance();
+    auto maybeIdx = app.GetOriginalIndex(app.controls.selected);
+    if (!maybeIdx) return false;
+    auto commandstr = extraArgs.empty()
+        ? app.state.lines.Substitute(m_compiledCommand, *maybeIdx)
+        : app.state.lines.Substitute(command, *maybeIdx);
+
     // native commands do not have/need an execPolicy.
     switch(m_execPolicy)
     {
@@ -26,12 +40,20 @@ bool Command::Execute(std::string_view extraArgs /*= ""*/) const {
             }
         case ExecutionPolicy::Silent:
             {
-                int err = ExecNoShell(commandstr);
-                return err == 0;
+                auto result = RunProcess(SplitCommand(commandstr), {.captureOutput = false});
+                return result && result->exitCode == 0;
             }
         case ExecutionPolicy::Modal:
             {
-                app.controls.display.string = ExecAndCapture(commandstr.c_str());
+                // In fxf's own process group: a background group would be
+                // stopped by a password prompt reading the terminal.
+                auto result = RunShell(commandstr, {.newProcessGroup = false, .maxOutput = kModalOutputLimit});
+                if (!result) {
+                    app.controls.display.string = result.error();
+                } else {
+                    app.controls.display.string = std::move(result->output);
+                    if (result->truncated) app.controls.display.string += "\n[Output truncated]\n";
+                }
                 app.controls.display.isActive = true;
                 return true;
             }
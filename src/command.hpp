@@ -4,6 +4,8 @@
 #include <functional>
 #include <vector>
 
+#include "template.hpp"
+
 class Command {
     using CommandFn = std::function<bool(const std::vector<std::string>&)>;
 
@@ -14,7 +16,7 @@ private:
     ExecutionPolicy m_execPolicy;
     CommandFn m_nativeCommandExecutor;
     std::string m_command;
-
+    CompiledTemplate m_compiledCommand;   // m_command + ' ', the no-extra-args form
 
 public:
     static const Command Null;
@@ -23,8 +25,9 @@ public:
         m_nativeCommandExecutor { std::move(nativeCommandExec)} {}
 
     Command(std::string command, ExecutionPolicy execPolicy) :
+        m_execPolicy(execPolicy),
         m_command(command),
-        m_execPolicy(execPolicy)
+        m_compiledCommand(m_command + ' ')
     {
     }
 
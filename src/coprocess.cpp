@@ -0,0 +1,313 @@
+#include "coprocess.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kReadBlock = 64 * 1024;
+constexpr size_t kMaxHeader = 20;   // Digits of a 64-bit length
+
+// write() with SIGPIPE blocked on this thread, so a helper that has died
+// shows up as EPIPE instead of killing fxf.
+ssize_t WriteNoSigpipe(int fd, const char* data, size_t size)
+{
+    sigset_t pipeSet, previous;
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &previous);
+
+    ssize_t n = ::write(fd, data, size);
+    if (n < 0 && errno == EPIPE) {
+        // Consume the SIGPIPE it raised before unblocking
+        timespec zero{};
+        ::sigtimedwait(&pipeSet, nullptr, &zero);
+        errno = EPIPE;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    return n;
+}
+
+void SetNonBlocking(int fd)
+{
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+}
+
+Coprocess::Coprocess(std::string command, std::chrono::milliseconds timeout)
+    : m_command(std::move(command)), m_timeout(timeout), m_wake(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+}
+
+Coprocess::~Coprocess()
+{
+    std::lock_guard lock(m_mutex);
+    Kill();
+    if (m_wake >= 0) ::close(m_wake);
+}
+
+pid_t Coprocess::Pid() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_pid;
+}
+
+size_t Coprocess::Starts() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_starts;
+}
+
+std::expected<std::string, std::string> Coprocess::Request(std::string_view payload, std::stop_token stop,
+                                                           const Sink& onOutput, bool* truncated)
+{
+    std::lock_guard lock(m_mutex);
+    if (truncated) *truncated = false;
+
+    // Clear a wake-up left over from an earlier stop, then listen for this one.
+    uint64_t ignored;
+    while (::read(m_wake, &ignored, sizeof ignored) > 0) {}
+    std::stop_callback onStop(stop, [this] {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(m_wake, &one, sizeof one);
+    });
+
+    const auto deadline = clock::now() + m_timeout;
+    for (int attempt = 0;; ++attempt) {
+        if (m_pid == 0) {
+            if (auto started = Start(); !started) return std::unexpected(started.error());
+        }
+
+        std::string response;
+        bool received = false;
+        bool skipped = false;
+        switch (Exchange(payload, deadline, onOutput, response, received, skipped)) {
+            case Io::Ok:
+                if (truncated) *truncated = skipped;
+                return response;
+            case Io::Stopped:
+                return std::string();
+            case Io::Timeout:
+                Kill();
+                return std::unexpected("Preview helper timed out: " + m_command);
+            case Io::Eof:
+                Kill();
+                // Died between requests, or on this one before answering: one more try
+                if (!received && attempt == 0) continue;
+                return std::unexpected("Preview helper exited: " + m_command);
+            case Io::Error:
+                Kill();
+                return std::unexpected("Malformed response from preview helper: " + m_command);
+        }
+    }
+}
+
+std::expected<void, std::string> Coprocess::Start()
+{
+    int toChild[2];
+    int fromChild[2];
+    if (::pipe2(toChild, O_CLOEXEC) != 0) {
+        return std::unexpected(std::string("Failed to create pipe: ") + std::strerror(errno));
+    }
+    if (::pipe2(fromChild, O_CLOEXEC) != 0) {
+        int error = errno;
+        ::close(toChild[0]);
+        ::close(toChild[1]);
+        return std::unexpected(std::string("Failed to create pipe: ") + std::strerror(error));
+    }
+
+    pid_t pid = ::fork();
+    if (pid == -1) {
+        int error = errno;
+        for (int fd : {toChild[0], toChild[1], fromChild[0], fromChild[1]}) ::close(fd);
+        return std::unexpected("Failed to start preview helper: " + m_command + ": " + std::strerror(error));
+    }
+
+    if (pid == 0) {
+        // The calling thread may have SIGPIPE blocked; the helper should not.
+        ::setpgid(0, 0);
+        sigset_t none;
+        sigemptyset(&none);
+        ::sigprocmask(SIG_SETMASK, &none, nullptr);
+
+        ::dup2(toChild[0], STDIN_FILENO);
+        ::dup2(fromChild[1], STDOUT_FILENO);
+        int devNull = ::open("/dev/null", O_WRONLY);
+        if (devNull >= 0) ::dup2(devNull, STDERR_FILENO);
+        ::execl("/bin/sh", "sh", "-c", m_command.c_str(), static_cast<char*>(nullptr));
+        ::_exit(127);
+    }
+
+    // Set on both sides so the group exists before Kill can target it.
+    ::setpgid(pid, pid);
+    ::close(toChild[0]);
+    ::close(fromChild[1]);
+
+    m_pid = pid;
+    m_in = toChild[1];
+    m_out = fromChild[0];
+    SetNonBlocking(m_in);
+    SetNonBlocking(m_out);
+    ++m_starts;
+    return {};
+}
+
+void Coprocess::Kill()
+{
+    if (m_pid > 0) {
+        ::kill(-m_pid, SIGKILL);
+        int status;
+        while (::waitpid(m_pid, &status, 0) == -1 && errno == EINTR) {}
+        m_pid = 0;
+    }
+    for (int* fd : {&m_in, &m_out}) {
+        if (*fd >= 0) ::close(*fd);
+        *fd = -1;
+    }
+    m_buffer.clear();
+    m_skipBytes = 0;
+    m_skipResponses = 0;
+}
+
+Coprocess::Io Coprocess::Exchange(std::string_view payload, clock::time_point deadline, const Sink& onOutput,
+                                  std::string& response, bool& received, bool& truncated)
+{
+    if (Io io = SkipAbandoned(deadline); io != Io::Ok) return io;
+
+    std::string request = std::to_string(payload.size()) + '\n';
+    request += payload;
+    if (Io io = WriteAll(request, deadline); io != Io::Ok) return io;
+
+    // Until its header is read, this response is skipped if we stop waiting.
+    ++m_skipResponses;
+    size_t length = 0;
+    if (Io io = ReadHeader(length, deadline); io != Io::Ok) return io;
+    --m_skipResponses;
+    received = true;
+
+    response.reserve(std::min(length, kReadBlock));
+    size_t left = length;
+    while (left > 0) {
+        if (m_buffer.empty()) {
+            if (Io io = Fill(deadline); io != Io::Ok) {
+                m_skipBytes = left;
+                return io;
+            }
+        }
+
+        size_t take = std::min(left, m_buffer.size());
+        std::string_view chunk(m_buffer.data(), take);
+        response.append(chunk);
+        left -= take;
+        bool more = !onOutput || onOutput(chunk);
+        m_buffer.erase(0, take);
+        if (!more) {
+            m_skipBytes = left;
+            truncated = left > 0;
+            break;
+        }
+    }
+    return Io::Ok;
+}
+
+Coprocess::Io Coprocess::SkipAbandoned(clock::time_point deadline)
+{
+    for (;;) {
+        while (m_skipBytes > 0) {
+            if (m_buffer.empty()) {
+                if (Io io = Fill(deadline); io != Io::Ok) return io;
+            }
+            size_t take = std::min(m_skipBytes, m_buffer.size());
+            m_buffer.erase(0, take);
+            m_skipBytes -= take;
+        }
+        if (m_skipResponses == 0) return Io::Ok;
+
+        size_t length = 0;
+        if (Io io = ReadHeader(length, deadline); io != Io::Ok) return io;
+        --m_skipResponses;
+        m_skipBytes = length;
+    }
+}
+
+Coprocess::Io Coprocess::ReadHeader(size_t& length, clock::time_point deadline)
+{
+    for (;;) {
+        if (size_t newline = m_buffer.find('\n'); newline != std::string::npos) {
+            const char* begin = m_buffer.data();
+            const char* end = begin + newline;
+            auto [ptr, ec] = std::from_chars(begin, end, length);
+            if (newline == 0 || ec != std::errc() || ptr != end || length > kMaxResponse) return Io::Error;
+            m_buffer.erase(0, newline + 1);
+            return Io::Ok;
+        }
+        if (m_buffer.size() > kMaxHeader) return Io::Error;
+        if (Io io = Fill(deadline); io != Io::Ok) return io;
+    }
+}
+
+Coprocess::Io Coprocess::Fill(clock::time_point deadline)
+{
+    char block[kReadBlock];
+    for (;;) {
+        ssize_t n = ::read(m_out, block, sizeof block);
+        if (n > 0) {
+            m_buffer.append(block, static_cast<size_t>(n));
+            return Io::Ok;
+        }
+        if (n == 0) return Io::Eof;
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) return Io::Error;
+        if (Io io = Wait(m_out, POLLIN, deadline); io != Io::Ok) return io;
+    }
+}
+
+Coprocess::Io Coprocess::WriteAll(std::string_view data, clock::time_point deadline)
+{
+    while (!data.empty()) {
+        ssize_t n = WriteNoSigpipe(m_in, data.data(), data.size());
+        if (n > 0) {
+            data.remove_prefix(static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) {
+            // Not interrupted by stop requests: half a request would leave
+            // the helper out of step with us.
+            if (Io io = Wait(m_in, POLLOUT, deadline, false); io != Io::Ok) return io;
+            continue;
+        }
+        return n < 0 && errno == EPIPE ? Io::Eof : Io::Error;
+    }
+    return Io::Ok;
+}
+
+Coprocess::Io Coprocess::Wait(int fd, short events, clock::time_point deadline, bool stoppable)
+{
+    for (;;) {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now());
+        if (left.count() <= 0) return Io::Timeout;
+
+        pollfd fds[2] = {{fd, events, 0}, {stoppable ? m_wake : -1, POLLIN, 0}};
+        int n = ::poll(fds, 2, static_cast<int>(std::min<int64_t>(left.count(), INT32_MAX)));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return Io::Error;
+        }
+        if (fds[1].revents & POLLIN) return Io::Stopped;
+        // Hang-ups and errors are reported by the read or write that follows
+        if (fds[0].revents != 0) return Io::Ok;
+    }
+}
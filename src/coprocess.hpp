@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+
+#include <sys/types.h>
+
+// A long-lived helper process answering one request at a time over its stdin
+// and stdout, so each request costs a pipe round trip instead of a fork/exec.
+//
+// Both directions use the same framing: the payload's length in bytes as a
+// decimal number and a newline, then the payload itself.
+//
+//     request:   14\nbat src/main.c        (from fxf to the helper)
+//     response:  <n>\n<n bytes of preview>  (from the helper back)
+//
+// The helper is started by the first request, runs in its own process group
+// with stderr discarded, and is restarted by the next request after it dies,
+// stops answering within the timeout, or sends a malformed frame.
+class Coprocess
+{
+public:
+    using Sink = std::function<bool(std::string_view chunk)>;
+
+    static constexpr std::chrono::milliseconds kDefaultTimeout{5000};
+    static constexpr size_t kMaxResponse = size_t{64} << 20;
+
+    explicit Coprocess(std::string command, std::chrono::milliseconds timeout = kDefaultTimeout);
+    ~Coprocess();
+
+    Coprocess(const Coprocess&) = delete;
+    Coprocess& operator=(const Coprocess&) = delete;
+
+    // Sends payload and returns the response; concurrent calls take turns. A
+    // helper found dead before any of the response arrived is restarted and
+    // asked once more. onOutput sees the response as it arrives; if it
+    // declines more, the rest is skipped, the part read so far returned and
+    // *truncated (if given) set. A stop request returns "" at once; the next
+    // request skips whatever of the abandoned response is still to come.
+    std::expected<std::string, std::string> Request(std::string_view payload, std::stop_token stop = {},
+                                                    const Sink& onOutput = {}, bool* truncated = nullptr);
+
+    const std::string& Command() const { return m_command; }
+    pid_t Pid() const;          // 0 while no helper is running
+    size_t Starts() const;      // Helpers started so far
+
+private:
+    enum class Io { Ok, Eof, Timeout, Stopped, Error };
+    using clock = std::chrono::steady_clock;
+
+    // All of these expect m_mutex to be held.
+    std::expected<void, std::string> Start();
+    void Kill();
+    Io Exchange(std::string_view payload, clock::time_point deadline, const Sink& onOutput,
+                std::string& response, bool& received, bool& truncated);
+    Io SkipAbandoned(clock::time_point deadline);
+    Io ReadHeader(size_t& length, clock::time_point deadline);
+    Io Fill(clock::time_point deadline);
+    Io WriteAll(std::string_view data, clock::time_point deadline);
+    Io Wait(int fd, short events, clock::time_point deadline, bool stoppable = true);
+
+    const std::string m_command;
+    const std::chrono::milliseconds m_timeout;
+    pid_t m_pid = 0;
+    int m_in = -1;                  // Helper's stdin
+    int m_out = -1;                 // Helper's stdout
+    int m_wake = -1;                // eventfd a stop request writes to, to end a poll
+    std::string m_buffer;           // Read from m_out but not consumed yet
+    size_t m_skipBytes = 0;         // Rest of a response abandoned mid-payload
+    size_t m_skipResponses = 0;     // Responses abandoned before their header arrived
+    size_t m_starts = 0;
+    mutable std::mutex m_mutex;
+};
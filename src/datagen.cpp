@@ -0,0 +1,264 @@
+#include "datagen.hpp"
+
+#include <charconv>
+
+namespace {
+
+constexpr std::string_view kDirs[] = {
+    "src", "include", "lib", "tests", "docs", "tools", "third_party", "build",
+    "core", "ui", "net", "util", "platform", "scripts", "assets", "vendor",
+};
+constexpr std::string_view kNames[] = {
+    "main", "app", "utils", "parser", "render", "config", "network", "cache",
+    "index", "search", "server", "client", "widget", "table", "stream", "buffer",
+};
+constexpr std::string_view kExts[] = {".cpp", ".hpp", ".c", ".h", ".md", ".py", ".rs", ".txt"};
+constexpr std::string_view kWords[] = {
+    "return", "const", "auto", "size_t", "std::string", "value", "result", "for",
+    "if", "else", "while", "template", "buffer", "index", "query", "TODO",
+    "fixme", "error", "request", "timeout", "connection", "handler", "update", "state",
+};
+constexpr std::string_view kLevels[] = {"DEBUG", "INFO", "INFO", "INFO", "WARN", "ERROR"};
+constexpr std::string_view kComponents[] = {"http", "db", "scheduler", "auth", "cache", "worker", "gc"};
+constexpr std::string_view kTags[] = {"alpha", "beta", "stable", "legacy", "hot", "cold", "archived"};
+
+// UTF-8 fragments of varying width: wide CJK and emoji, accented Latin,
+// base letters with combining marks, and zero-width joiner sequences.
+constexpr std::string_view kUnicodeWords[] = {
+    "日本語", "漢字", "検索", "ファイル", "한국어", "中文字符", "😀", "🚀", "👩‍💻",
+    "café", "naïve", "Ærøskøbing", "Straße", "élève", "äö",
+    "Ελληνικά", "кириллица", "עברית", "العربية", "ＡＢＣ", "ｶﾀｶﾅ", "plain",
+};
+
+template <typename T, size_t N>
+const T& Pick(SplitMix64& rng, const T (&table)[N])
+{
+    return table[rng.Below(N)];
+}
+
+void AppendNumber(std::string& out, uint64_t value)
+{
+    char buf[24];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof buf, value);
+    out.append(buf, end);
+}
+
+// Zero-padded to `width` digits
+void AppendPadded(std::string& out, uint64_t value, int width)
+{
+    char buf[24];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof buf, value);
+    for (int pad = width - static_cast<int>(end - buf); pad > 0; --pad) out += '0';
+    out.append(buf, end);
+}
+
+// Fixed-point decimal from an integer number of hundredths, so the output
+// does not depend on floating-point formatting.
+void AppendDecimal(std::string& out, uint64_t hundredths)
+{
+    AppendNumber(out, hundredths / 100);
+    out += '.';
+    AppendPadded(out, hundredths % 100, 2);
+}
+
+void AppendDate(std::string& out, SplitMix64& rng)
+{
+    AppendNumber(out, 2000 + rng.Below(26));
+    out += '-';
+    AppendPadded(out, 1 + rng.Below(12), 2);
+    out += '-';
+    AppendPadded(out, 1 + rng.Below(28), 2);
+}
+
+// Milliseconds since the epoch as an ISO-8601 UTC timestamp
+void AppendTimestamp(std::string& out, uint64_t ms)
+{
+    uint64_t days = ms / 86'400'000;
+    uint64_t dayMs = ms % 86'400'000;
+
+    // Civil-from-days (Howard Hinnant)
+    int64_t z = static_cast<int64_t>(days) + 719468;
+    int64_t era = z / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    uint64_t day = static_cast<uint64_t>(doy - (153 * mp + 2) / 5 + 1);
+    uint64_t month = static_cast<uint64_t>(mp < 10 ? mp + 3 : mp - 9);
+    uint64_t year = static_cast<uint64_t>(yoe + era * 400 + (month <= 2));
+
+    AppendNumber(out, year);
+    out += '-';
+    AppendPadded(out, month, 2);
+    out += '-';
+    AppendPadded(out, day, 2);
+    out += 'T';
+    AppendPadded(out, dayMs / 3'600'000, 2);
+    out += ':';
+    AppendPadded(out, dayMs / 60'000 % 60, 2);
+    out += ':';
+    AppendPadded(out, dayMs / 1000 % 60, 2);
+    out += '.';
+    AppendPadded(out, dayMs % 1000, 3);
+    out += 'Z';
+}
+
+}
+
+std::optional<DataShape> ParseDataShape(std::string_view name)
+{
+    for (DataShape shape : {DataShape::Paths, DataShape::Vimgrep, DataShape::Table, DataShape::Log, DataShape::Unicode}) {
+        if (DataShapeName(shape) == name) return shape;
+    }
+    return std::nullopt;
+}
+
+std::string_view DataShapeName(DataShape shape)
+{
+    switch (shape) {
+        case DataShape::Paths:   return "paths";
+        case DataShape::Vimgrep: return "vimgrep";
+        case DataShape::Table:   return "table";
+        case DataShape::Log:     return "log";
+        case DataShape::Unicode: return "unicode";
+    }
+    return "";
+}
+
+std::optional<uint64_t> ParseCount(std::string_view text)
+{
+    uint64_t multiplier = 1;
+    if (!text.empty()) {
+        switch (text.back()) {
+            case 'k': case 'K': multiplier = 1'000; break;
+            case 'm': case 'M': multiplier = 1'000'000; break;
+            case 'g': case 'G': multiplier = 1'000'000'000; break;
+        }
+        if (multiplier != 1) text.remove_suffix(1);
+    }
+
+    uint64_t value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || ec != std::errc{} || ptr != text.data() + text.size()) return std::nullopt;
+    if (value > UINT64_MAX / multiplier) return std::nullopt;
+    return value * multiplier;
+}
+
+DataGenerator::DataGenerator(const DataGenOptions& options)
+    : m_options(options)
+    , m_rng(options.seed)
+{
+    if (m_options.columns == 0) m_options.columns = 1;
+}
+
+void DataGenerator::AppendPath(std::string& out)
+{
+    for (uint64_t depth = 1 + m_rng.Below(4); depth > 0; --depth) {
+        out += Pick(m_rng, kDirs);
+        out += '/';
+    }
+    out += Pick(m_rng, kNames);
+    AppendNumber(out, m_rng.Below(100));
+    out += Pick(m_rng, kExts);
+}
+
+void DataGenerator::AppendText(std::string& out, uint64_t words)
+{
+    for (uint64_t i = 0; i < words; ++i) {
+        if (i > 0) out += ' ';
+        out += Pick(m_rng, kWords);
+    }
+}
+
+void DataGenerator::AppendUnicodeText(std::string& out, uint64_t words)
+{
+    for (uint64_t i = 0; i < words; ++i) {
+        if (i > 0) out += ' ';
+        out += Pick(m_rng, kUnicodeWords);
+    }
+}
+
+bool DataGenerator::AppendNext(std::string& out)
+{
+    if (m_produced >= m_options.rows) return false;
+    const char delim = m_options.delimiter;
+
+    switch (m_options.shape) {
+        case DataShape::Paths:
+            AppendPath(out);
+            break;
+
+        case DataShape::Vimgrep:
+            AppendPath(out);
+            out += delim;
+            AppendNumber(out, 1 + m_rng.Below(5000));
+            out += delim;
+            AppendNumber(out, 1 + m_rng.Below(120));
+            out += delim;
+            out.append(m_rng.Below(4) * 4, ' ');
+            AppendText(out, 2 + m_rng.Below(12));
+            break;
+
+        case DataShape::Table:
+            AppendNumber(out, m_produced + 1);
+            for (size_t column = 1; column < m_options.columns; ++column) {
+                out += delim;
+                switch (column % 6) {
+                    case 1: out += Pick(m_rng, kNames); out += '_'; AppendNumber(out, m_rng.Below(10000)); break;
+                    case 2: AppendNumber(out, m_rng.Below(1'000'000)); break;
+                    case 3: AppendDecimal(out, m_rng.Below(10'000'000)); break;
+                    case 4: AppendDate(out, m_rng); break;
+                    case 5: out += Pick(m_rng, kTags); break;
+                    case 0: AppendText(out, 1 + m_rng.Below(3)); break;
+                }
+            }
+            break;
+
+        case DataShape::Log: {
+            m_timestampMs += m_rng.Below(250);
+            AppendTimestamp(out, m_timestampMs);
+            out += delim;
+            out += Pick(m_rng, kLevels);
+            out += delim;
+            out += Pick(m_rng, kComponents);
+            out += delim;
+            // Mostly short messages with a long tail of multi-KB ones
+            uint64_t words = 8 + m_rng.Below(32);
+            if (m_rng.Below(16) == 0) words += m_rng.Below(600);
+            AppendText(out, words);
+            break;
+        }
+
+        case DataShape::Unicode:
+            AppendUnicodeText(out, 1 + m_rng.Below(3));
+            out += delim;
+            AppendNumber(out, m_rng.Below(100000));
+            out += delim;
+            AppendUnicodeText(out, 2 + m_rng.Below(10));
+            break;
+    }
+
+    ++m_produced;
+    return true;
+}
+
+bool WriteDataset(const DataGenOptions& options, std::FILE* out)
+{
+    static constexpr size_t kFlushSize = 1 << 20;
+
+    DataGenerator generator(options);
+    std::string buffer;
+    buffer.reserve(kFlushSize + 64 * 1024);
+
+    auto flush = [&] {
+        bool ok = buffer.empty() || std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+        buffer.clear();
+        return ok;
+    };
+
+    while (generator.AppendNext(buffer)) {
+        buffer += '\n';
+        if (buffer.size() >= kFlushSize && !flush()) return false;
+    }
+    return flush() && std::fflush(out) == 0;
+}
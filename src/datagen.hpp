@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Synthetic inputs for benchmarks and stress tests. The same options always
+// produce the same bytes, on any platform.
+
+// Deterministic 64-bit pseudo-random numbers (SplitMix64).
+class SplitMix64
+{
+public:
+    explicit SplitMix64(uint64_t seed) : m_state(seed) {}
+
+    uint64_t Next()
+    {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform enough in [0, bound) for bounds far below 2^64.
+    uint64_t Below(uint64_t bound) { return Next() % bound; }
+
+private:
+    uint64_t m_state;
+};
+
+enum class DataShape {
+    Paths,     // dir/dir/name.ext
+    Vimgrep,   // path|line|col|text, like `rg --vimgrep` with fxf's delimiter
+    Table,     // Wide rows: id, name, numbers, dates, tags... (`columns` fields)
+    Log,       // timestamp|level|component|message, messages up to a few KB
+    Unicode,   // CJK, emoji, combining marks and accented Latin in every field
+};
+
+std::optional<DataShape> ParseDataShape(std::string_view name);
+std::string_view DataShapeName(DataShape shape);
+
+// Parses a count with an optional k/m/g suffix (powers of 1000), e.g. "10m".
+std::optional<uint64_t> ParseCount(std::string_view text);
+
+struct DataGenOptions {
+    DataShape shape = DataShape::Vimgrep;
+    uint64_t rows = 1000;
+    uint64_t seed = 42;
+    size_t columns = 12;      // Fields per row for DataShape::Table
+    char delimiter = '|';
+};
+
+// Produces one row at a time, so any size can be streamed.
+class DataGenerator
+{
+public:
+    explicit DataGenerator(const DataGenOptions& options);
+
+    // Appends the next row (without a newline) to out; false once `rows` rows were produced.
+    bool AppendNext(std::string& out);
+
+    uint64_t Produced() const { return m_produced; }
+
+private:
+    void AppendPath(std::string& out);
+    void AppendText(std::string& out, uint64_t words);
+    void AppendUnicodeText(std::string& out, uint64_t words);
+
+    DataGenOptions m_options;
+    SplitMix64 m_rng;
+    uint64_t m_produced = 0;
+    uint64_t m_timestampMs = 1'700'000'000'000;
+};
+
+// Writes all rows, newline-terminated, to out in large blocks.
+// Returns false on a write error.
+bool WriteDataset(const DataGenOptions& options, std::FILE* out);
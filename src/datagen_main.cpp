@@ -0,0 +1,40 @@
+#include <iostream>
+#include <CLI/CLI.hpp>
+
+#include "datagen.hpp"
+
+// fxf-gen: writes synthetic datasets to stdout, e.g. `fxf-gen vimgrep -n 10m > big.txt`.
+int main(int argc, char* argv[]) {
+
+    CLI::App args{"fxf-gen - deterministic synthetic input for fxf"};
+
+    std::string shapeName;
+    std::string rows = "1000";
+    DataGenOptions options;
+    args.add_option("shape", shapeName, "paths, vimgrep, table, log or unicode")->required();
+    args.add_option("-n,--rows", rows, "Number of rows, with optional k/m/g suffix");
+    args.add_option("-s,--seed", options.seed, "Random seed");
+    args.add_option("-c,--columns", options.columns, "Fields per row for the table shape");
+    args.add_option("-d,--delimiter", options.delimiter, "Delimiter");
+
+    CLI11_PARSE(args, argc, argv);
+
+    auto shape = ParseDataShape(shapeName);
+    if (!shape) {
+        std::cerr << "Error: Unknown shape: " << shapeName << "\n";
+        return 2;
+    }
+    auto count = ParseCount(rows);
+    if (!count) {
+        std::cerr << "Error: Invalid row count: " << rows << "\n";
+        return 2;
+    }
+    options.shape = *shape;
+    options.rows = *count;
+
+    if (!WriteDataset(options, stdout)) {
+        std::cerr << "Error: Write failed\n";
+        return 1;
+    }
+    return 0;
+}
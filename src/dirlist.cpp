@@ -0,0 +1,188 @@
+#include "dirlist.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+struct DirCloser {
+    void operator()(DIR* dir) const { ::closedir(dir); }
+};
+
+bool IsDotOrDotDot(const char* name)
+{
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+void StatEntry(int dirFd, DirEntry& entry)
+{
+    struct stat st;
+    if (::fstatat(dirFd, entry.name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) return;
+
+    entry.mode = st.st_mode;
+    entry.size = static_cast<uint64_t>(st.st_size);
+    entry.mtime = static_cast<int64_t>(st.st_mtim.tv_sec);
+
+    if (S_ISLNK(st.st_mode)) {
+        char target[4096];
+        ssize_t n = ::readlinkat(dirFd, entry.name.c_str(), target, sizeof target);
+        if (n > 0) entry.target.assign(target, static_cast<size_t>(n));
+    }
+}
+
+// "Oct 19 14:03" for the last six months, "Oct 19  2025" otherwise, like ls.
+void AppendTime(std::string& out, int64_t mtime, std::time_t now)
+{
+    constexpr int64_t kHalfYear = 6 * 30 * 24 * 3600;
+    std::time_t time = static_cast<std::time_t>(mtime);
+    std::tm tm{};
+    if (!::localtime_r(&time, &tm)) {
+        out += "?            ";
+        return;
+    }
+
+    bool recent = mtime <= now && now - mtime < kHalfYear;
+    char buffer[32];
+    size_t n = std::strftime(buffer, sizeof buffer, recent ? "%b %e %H:%M" : "%b %e  %Y", &tm);
+    out.append(buffer, n);
+}
+
+}
+
+std::expected<DirListing, std::string> ListDirectory(const std::string& path, size_t limit,
+                                                     size_t countCap, std::stop_token stop)
+{
+    std::unique_ptr<DIR, DirCloser> dir(::opendir(path.c_str()));
+    if (!dir) {
+        return std::unexpected("Failed to open directory: " + path + ": " + std::strerror(errno));
+    }
+
+    DirListing listing;
+
+    // Max-heap of the smallest names seen so far, so the largest is evicted first
+    std::vector<std::string> names;
+    names.reserve(limit);
+
+    while (listing.total < countCap) {
+        if (listing.total % 4096 == 0 && stop.stop_requested()) break;
+
+        errno = 0;
+        const dirent* ent = ::readdir(dir.get());
+        if (!ent) {
+            if (errno != 0) {
+                return std::unexpected("Failed to read directory: " + path + ": " + std::strerror(errno));
+            }
+            break;
+        }
+        if (IsDotOrDotDot(ent->d_name)) continue;
+
+        ++listing.total;
+        if (names.size() < limit) {
+            names.emplace_back(ent->d_name);
+            std::ranges::push_heap(names);
+        } else if (limit > 0 && std::strcmp(ent->d_name, names.front().c_str()) < 0) {
+            std::ranges::pop_heap(names);
+            names.back().assign(ent->d_name);
+            std::ranges::push_heap(names);
+        }
+    }
+
+    // At the cap, look for one more entry to tell whether the count is exact
+    if (listing.total == countCap) {
+        errno = 0;
+        for (const dirent* ent; (ent = ::readdir(dir.get())) != nullptr;) {
+            if (!IsDotOrDotDot(ent->d_name)) {
+                listing.capped = true;
+                break;
+            }
+        }
+    }
+
+    std::ranges::sort_heap(names);
+    const int dirFd = ::dirfd(dir.get());
+    listing.entries.reserve(names.size());
+    for (std::string& name : names) {
+        DirEntry& entry = listing.entries.emplace_back();
+        entry.name = std::move(name);
+        StatEntry(dirFd, entry);
+    }
+    return listing;
+}
+
+std::string FormatMode(mode_t mode)
+{
+    std::string out(10, '-');
+    switch (mode & S_IFMT) {
+        case S_IFDIR:  out[0] = 'd'; break;
+        case S_IFLNK:  out[0] = 'l'; break;
+        case S_IFCHR:  out[0] = 'c'; break;
+        case S_IFBLK:  out[0] = 'b'; break;
+        case S_IFIFO:  out[0] = 'p'; break;
+        case S_IFSOCK: out[0] = 's'; break;
+        case S_IFREG:  break;
+        default:       out[0] = '?'; break;
+    }
+
+    constexpr mode_t kBits[9] = {S_IRUSR, S_IWUSR, S_IXUSR, S_IRGRP, S_IWGRP, S_IXGRP, S_IROTH, S_IWOTH, S_IXOTH};
+    for (size_t i = 0; i < 9; ++i) {
+        if (mode & kBits[i]) out[1 + i] = "rwx"[i % 3];
+    }
+
+    // setuid/setgid/sticky replace the matching execute bit
+    if (mode & S_ISUID) out[3] = (mode & S_IXUSR) ? 's' : 'S';
+    if (mode & S_ISGID) out[6] = (mode & S_IXGRP) ? 's' : 'S';
+    if (mode & S_ISVTX) out[9] = (mode & S_IXOTH) ? 't' : 'T';
+    return out;
+}
+
+std::string FormatListing(const DirListing& listing)
+{
+    if (listing.total == 0) return "(empty directory)\n";
+
+    size_t sizeWidth = 1;
+    for (const DirEntry& entry : listing.entries) {
+        sizeWidth = std::max(sizeWidth, std::to_string(entry.size).size());
+    }
+
+    const std::time_t now = std::time(nullptr);
+    std::string out;
+    for (const DirEntry& entry : listing.entries) {
+        if (entry.mode == 0) {
+            // Removed between reading the directory and stat'ing it
+            out += "?????????? ";
+            out.append(sizeWidth, '?');
+            out += " ?            ";
+        } else {
+            out += FormatMode(entry.mode);
+            out += ' ';
+            std::string size = std::to_string(entry.size);
+            out.append(sizeWidth - size.size(), ' ');
+            out += size;
+            out += ' ';
+            AppendTime(out, entry.mtime, now);
+        }
+        out += ' ';
+        out += entry.name;
+        if (!entry.target.empty()) {
+            out += " -> ";
+            out += entry.target;
+        }
+        out += '\n';
+    }
+
+    size_t hidden = listing.total - listing.entries.size();
+    if (listing.capped) {
+        out += "... and over " + std::to_string(hidden) + " more entries\n";
+    } else if (hidden > 0) {
+        out += "... and " + std::to_string(hidden) + " more entries\n";
+    }
+    return out;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+// In-process replacement for `ls -la | head`: the directory is read once,
+// only the names that sort first are kept, and only those are stat'ed.
+
+struct DirEntry {
+    std::string name;
+    std::string target;     // Where a symlink points
+    mode_t mode = 0;        // 0 if the entry vanished before it was stat'ed
+    uint64_t size = 0;
+    int64_t mtime = 0;      // Seconds since the epoch
+};
+
+struct DirListing {
+    std::vector<DirEntry> entries;  // The first `limit` entries by name, "." and ".." excluded
+    size_t total = 0;               // Entries read
+    bool capped = false;            // Reading stopped at `countCap`; more entries exist
+};
+
+constexpr size_t kDefaultCountCap = 100'000;
+
+// Reads up to countCap entries of path and returns the `limit` smallest names
+// in byte order, stat'ed without following symlinks. Past the cap the result
+// is sorted among the entries read only. A stop request ends reading early.
+std::expected<DirListing, std::string> ListDirectory(const std::string& path, size_t limit,
+                                                     size_t countCap = kDefaultCountCap,
+                                                     std::stop_token stop = {});
+
+// `ls -l` style permission string, e.g. "drwxr-xr-x".
+std::string FormatMode(mode_t mode);
+
+// One line per entry: mode, size, mtime and name (" -> target" for symlinks),
+// followed by a count of the entries not shown.
+std::string FormatListing(const DirListing& listing);
@@ -0,0 +1,307 @@
+#include "disk_cache.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t kMagic = 0x31565846;     // "FXV1"
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t keySize;
+    uint32_t valueSize;
+    uint32_t checksum;      // FNV-1a of key and value
+};
+
+constexpr uint64_t RecordSize(uint64_t keySize, uint64_t valueSize)
+{
+    return sizeof(RecordHeader) + keySize + valueSize;
+}
+
+uint32_t Checksum(std::string_view key, std::string_view value)
+{
+    uint32_t hash = 2166136261u;
+    for (std::string_view part : {key, value}) {
+        for (unsigned char c : part) {
+            hash = (hash ^ c) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+bool ReadAll(int fd, char* buffer, size_t size, uint64_t offset)
+{
+    while (size > 0) {
+        ssize_t n = ::pread(fd, buffer, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buffer += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool WriteAll(int fd, const char* buffer, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = ::write(fd, buffer, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buffer += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+uint64_t FileSize(int fd)
+{
+    struct stat st;
+    return ::fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+// Holds an exclusive flock for the scope.
+class FileLock
+{
+public:
+    explicit FileLock(int fd) : m_fd(fd) { while (::flock(m_fd, LOCK_EX) != 0 && errno == EINTR) {} }
+    ~FileLock() { ::flock(m_fd, LOCK_UN); }
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    int m_fd;
+};
+
+int OpenStore(const std::string& path)
+{
+    return ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+
+}
+
+std::expected<std::unique_ptr<DiskCache>, std::string> DiskCache::Open(const std::string& dir, uint64_t capacity)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        return std::unexpected("Cannot create preview cache directory " + dir + ": " + ec.message());
+    }
+
+    std::string path = (std::filesystem::path(dir) / kFileName).string();
+    int fd = OpenStore(path);
+    if (fd < 0) {
+        return std::unexpected("Cannot open preview cache " + path + ": " + std::strerror(errno));
+    }
+
+    std::unique_ptr<DiskCache> cache(new DiskCache(std::move(path), fd, capacity));
+    std::lock_guard lock(cache->m_mutex);
+    cache->LoadIndex();
+    return cache;
+}
+
+DiskCache::DiskCache(std::string path, int fd, uint64_t capacity)
+    : m_path(std::move(path))
+    , m_capacity(capacity)
+    , m_fd(fd)
+{
+}
+
+DiskCache::~DiskCache()
+{
+    ::close(m_fd);
+}
+
+void DiskCache::LoadIndex()
+{
+    FileLock fileLock(m_fd);
+    m_index.clear();
+
+    // Later records replace earlier ones, so file order doubles as recency.
+    const uint64_t size = FileSize(m_fd);
+    uint64_t offset = 0;
+    std::string key;
+    while (offset + sizeof(RecordHeader) <= size) {
+        RecordHeader header;
+        if (!ReadAll(m_fd, reinterpret_cast<char*>(&header), sizeof header, offset)) break;
+        if (header.magic != kMagic) break;
+        const uint64_t recordSize = RecordSize(header.keySize, header.valueSize);
+        if (offset + recordSize > size) break;
+
+        key.resize(header.keySize);
+        if (!ReadAll(m_fd, key.data(), key.size(), offset + sizeof header)) break;
+        m_index.insert_or_assign(key, Slot{offset, header.keySize, header.valueSize, ++m_tick});
+        offset += recordSize;
+    }
+
+    // A record cut short by a crash ends the file; drop it so appends line up.
+    // If that fails, new records are appended after it and still indexed.
+    if (offset < size && ::ftruncate(m_fd, static_cast<off_t>(offset)) == 0) {
+        m_fileBytes = offset;
+    } else {
+        m_fileBytes = size;
+    }
+}
+
+bool DiskCache::ReopenIfReplaced()
+{
+    // Another session may have compacted the store into a new file.
+    struct stat ours, current;
+    if (::fstat(m_fd, &ours) != 0 || ::stat(m_path.c_str(), &current) != 0) return false;
+    if (ours.st_ino == current.st_ino && ours.st_dev == current.st_dev) return false;
+
+    int fd = OpenStore(m_path);
+    if (fd < 0) return false;
+    ::close(m_fd);
+    m_fd = fd;
+    LoadIndex();
+    return true;
+}
+
+std::optional<std::string> DiskCache::Lookup(std::string_view key)
+{
+    std::lock_guard lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) return std::nullopt;
+
+    const Slot& slot = it->second;
+    std::string record(RecordSize(slot.keySize, slot.valueSize), '\0');
+    RecordHeader header;
+    bool valid = ReadAll(m_fd, record.data(), record.size(), slot.offset);
+    if (valid) {
+        std::memcpy(&header, record.data(), sizeof header);
+        std::string_view storedKey(record.data() + sizeof header, slot.keySize);
+        std::string_view value(record.data() + sizeof header + slot.keySize, slot.valueSize);
+        valid = header.magic == kMagic && header.keySize == slot.keySize && header.valueSize == slot.valueSize
+             && storedKey == key && header.checksum == Checksum(storedKey, value);
+    }
+    if (!valid) {
+        m_index.erase(it);
+        return std::nullopt;
+    }
+
+    it->second.lastUse = ++m_tick;
+    record.erase(0, sizeof header + slot.keySize);
+    return record;
+}
+
+void DiskCache::Insert(std::string_view key, std::string_view value)
+{
+    const uint64_t recordSize = RecordSize(key.size(), value.size());
+    if (recordSize > m_capacity || key.size() > UINT32_MAX || value.size() > UINT32_MAX) return;
+
+    RecordHeader header{kMagic, static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size()),
+                        Checksum(key, value)};
+    std::string record;
+    record.reserve(recordSize);
+    record.append(reinterpret_cast<const char*>(&header), sizeof header);
+    record.append(key);
+    record.append(value);
+
+    std::lock_guard lock(m_mutex);
+    ReopenIfReplaced();
+    {
+        FileLock fileLock(m_fd);
+        const uint64_t offset = FileSize(m_fd);
+        if (!WriteAll(m_fd, record.data(), record.size())) return;
+        m_fileBytes = offset + recordSize;
+
+        auto it = m_index.find(key);
+        Slot slot{offset, header.keySize, header.valueSize, ++m_tick};
+        if (it != m_index.end()) {
+            it->second = slot;
+        } else {
+            m_index.emplace(std::string(key), slot);
+        }
+    }
+
+    if (m_fileBytes > m_capacity) Compact();
+}
+
+void DiskCache::Compact()
+{
+    // Keep the most recently used records, up to three quarters of capacity,
+    // so compaction does not run again after a few more inserts.
+    std::vector<std::pair<const std::string*, Slot*>> live;
+    live.reserve(m_index.size());
+    for (auto& [key, slot] : m_index) live.emplace_back(&key, &slot);
+    std::ranges::sort(live, std::greater<>(), [](const auto& entry) { return entry.second->lastUse; });
+
+    const uint64_t target = m_capacity / 4 * 3;
+    uint64_t kept = 0;
+    size_t count = 0;
+    for (; count < live.size(); ++count) {
+        const Slot& slot = *live[count].second;
+        uint64_t size = RecordSize(slot.keySize, slot.valueSize);
+        if (kept + size > target) break;
+        kept += size;
+    }
+    live.resize(count);
+    std::ranges::reverse(live);     // Oldest first, so reloading keeps the order
+
+    const std::string tmpPath = m_path + ".tmp";
+    int tmp = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (tmp < 0) return;
+
+    std::unordered_map<std::string, Slot, KeyHash, std::equal_to<>> index;
+    uint64_t offset = 0;
+    bool replaced = false;
+    {
+        FileLock fileLock(m_fd);
+        std::string record;
+        bool written = true;
+        for (const auto& [key, slot] : live) {
+            record.resize(RecordSize(slot->keySize, slot->valueSize));
+            if (!ReadAll(m_fd, record.data(), record.size(), slot->offset)) continue;
+            if (!WriteAll(tmp, record.data(), record.size())) {
+                written = false;
+                break;
+            }
+            index.emplace(*key, Slot{offset, slot->keySize, slot->valueSize, slot->lastUse});
+            offset += record.size();
+        }
+        replaced = written && ::rename(tmpPath.c_str(), m_path.c_str()) == 0;
+    }
+
+    if (!replaced) {
+        ::close(tmp);
+        ::unlink(tmpPath.c_str());
+        return;
+    }
+    ::close(m_fd);
+    m_fd = tmp;
+    m_index = std::move(index);
+    m_fileBytes = offset;
+}
+
+size_t DiskCache::Entries() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_index.size();
+}
+
+uint64_t DiskCache::FileBytes() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_fileBytes;
+}
+
+size_t DiskCache::HeapBytes() const
+{
+    std::lock_guard lock(m_mutex);
+    size_t bytes = m_index.bucket_count() * sizeof(void*);
+    for (const auto& [key, slot] : m_index) {
+        bytes += 2 * sizeof(void*) + sizeof(std::string) + sizeof(Slot) + ::HeapBytes(key);
+    }
+    return bytes;
+}
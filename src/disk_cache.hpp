@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Persistent key/value store for rendered previews, kept in one append-only
+// file in a directory. Each record is a small header, the key and the value.
+// The index of live records lives in memory: it is rebuilt from the record
+// headers on open, after which a lookup is one hash probe plus one pread.
+//
+// Replacing a key appends a new record and leaves the old one dead. Once the
+// file outgrows its capacity it is compacted: the most recently used live
+// records are copied, oldest first, into a new file that replaces the old one.
+// Safe to use from several threads; appends and compaction also take an
+// exclusive flock so sessions can share a directory.
+class DiskCache
+{
+public:
+    static constexpr uint64_t kDefaultCapacity = uint64_t{256} << 20;
+    static constexpr const char* kFileName = "previews.dat";
+
+    static std::expected<std::unique_ptr<DiskCache>, std::string> Open(const std::string& dir,
+                                                                      uint64_t capacity = kDefaultCapacity);
+    ~DiskCache();
+
+    DiskCache(const DiskCache&) = delete;
+    DiskCache& operator=(const DiskCache&) = delete;
+
+    // The value stored for key; records that fail their checksum are dropped.
+    std::optional<std::string> Lookup(std::string_view key);
+
+    void Insert(std::string_view key, std::string_view value);
+
+    size_t Entries() const;
+    uint64_t FileBytes() const;     // Size of the store, dead records included
+    size_t HeapBytes() const;       // Size of the in-memory index
+
+private:
+    struct Slot {
+        uint64_t offset;        // Of the record header
+        uint32_t keySize;
+        uint32_t valueSize;
+        uint64_t lastUse;
+    };
+
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+    };
+
+    DiskCache(std::string path, int fd, uint64_t capacity);
+
+    // All of these expect m_mutex to be held.
+    void LoadIndex();
+    bool ReopenIfReplaced();
+    void Compact();
+
+    const std::string m_path;
+    const uint64_t m_capacity;
+    int m_fd;
+    uint64_t m_fileBytes = 0;
+    uint64_t m_tick = 0;
+    std::unordered_map<std::string, Slot, KeyHash, std::equal_to<>> m_index;
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,238 @@
+#include "fileview.hpp"
+#include "unicode.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t kBlockBytes = 64 * 1024;
+
+// Stop once this much text is collected, so a window over a few huge lines
+// (minified code, a single-line JSON dump) does not read the whole file.
+constexpr size_t kMaxExcerptBytes = 1 << 20;
+
+class FileDescriptor
+{
+public:
+    explicit FileDescriptor(int fd) : m_fd(fd) {}
+    ~FileDescriptor() { if (m_fd >= 0) ::close(m_fd); }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int Get() const { return m_fd; }
+
+private:
+    int m_fd;
+};
+
+// pread that retries when interrupted.
+ssize_t ReadAt(int fd, char* buffer, size_t size, uint64_t offset)
+{
+    ssize_t n;
+    do {
+        n = ::pread(fd, buffer, size, static_cast<off_t>(offset));
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+}
+
+size_t CountNewlines(const char* data, size_t size)
+{
+    size_t count = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        count += std::popcount(mask);
+    }
+#endif
+    for (; i < size; ++i) {
+        count += data[i] == '\n';
+    }
+    return count;
+}
+
+std::expected<LineIndex::Checkpoint, std::string> LineIndex::Seek(int fd, size_t line)
+{
+    std::lock_guard lock(m_mutex);
+    const size_t wanted = (std::max<size_t>(line, 1) - 1) / kStride;
+
+    std::string block;
+    while (m_offsets.size() <= wanted && !m_complete) {
+        block.resize(kBlockBytes);
+        ssize_t n = ReadAt(fd, block.data(), block.size(), m_scanned);
+        if (n < 0) return std::unexpected(std::string("Failed to index file: ") + std::strerror(errno));
+        if (n == 0) {
+            m_complete = true;
+            break;
+        }
+
+        // Count whole runs without a checkpoint; only the newline that starts
+        // the next stride is located exactly.
+        const char* data = block.data();
+        size_t pos = 0;
+        while (pos < static_cast<size_t>(n)) {
+            uint64_t needed = m_offsets.size() * kStride - m_newlines;
+            size_t inRest = CountNewlines(data + pos, n - pos);
+            if (inRest < needed) {
+                m_newlines += inRest;
+                break;
+            }
+            for (; needed > 0; --needed) {
+                pos = static_cast<const char*>(std::memchr(data + pos, '\n', n - pos)) - data + 1;
+            }
+            m_newlines = m_offsets.size() * kStride;
+            m_offsets.push_back(m_scanned + pos);
+        }
+        m_scanned += n;
+    }
+
+    size_t k = std::min(wanted, m_offsets.size() - 1);
+    return Checkpoint{k * kStride + 1, m_offsets[k]};
+}
+
+size_t LineIndex::Checkpoints() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_offsets.size();
+}
+
+size_t LineIndex::HeapBytes() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_offsets.capacity() * sizeof(uint64_t);
+}
+
+std::shared_ptr<LineIndex> LineIndexCache::Get(const std::string& path, FileStamp stamp)
+{
+    std::lock_guard lock(m_mutex);
+    ++m_tick;
+
+    if (auto it = m_entries.find(path); it != m_entries.end()) {
+        if (it->second.index->Stamp() == stamp) {
+            it->second.lastUse = m_tick;
+            return it->second.index;
+        }
+        m_entries.erase(it);
+    }
+
+    if (m_entries.size() >= kMaxFiles) {
+        auto oldest = std::ranges::min_element(m_entries, {}, [](const auto& entry) { return entry.second.lastUse; });
+        m_entries.erase(oldest);
+    }
+
+    auto index = std::make_shared<LineIndex>(stamp);
+    m_entries.emplace(path, Entry{index, m_tick});
+    return index;
+}
+
+void LineIndexCache::Clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_entries.clear();
+}
+
+size_t LineIndexCache::Size() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_entries.size();
+}
+
+size_t LineIndexCache::HeapBytes() const
+{
+    std::lock_guard lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto& [path, entry] : m_entries) {
+        bytes += path.capacity() + sizeof(LineIndex) + entry.index->HeapBytes();
+    }
+    return bytes;
+}
+
+bool LooksBinary(std::string_view head, bool truncated)
+{
+    if (std::memchr(head.data(), '\0', head.size()) != nullptr) return true;
+
+    size_t valid = ValidUtf8Length(head);
+    if (valid == head.size()) return false;
+    return !(truncated && head.size() - valid < 4);
+}
+
+std::expected<FileExcerpt, std::string> ReadFileLines(const std::string& path, size_t first, size_t count,
+                                                      LineIndexCache* indexes)
+{
+    FileDescriptor fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd.Get() < 0) {
+        return std::unexpected("Failed to open file: " + path);
+    }
+
+    FileExcerpt excerpt;
+    std::string block(kBlockBytes, '\0');
+    const size_t end = std::max<size_t>(first, 1) + count;
+    size_t line = 1;
+    uint64_t offset = 0;
+
+    if (indexes && first > LineIndex::kStride) {
+        struct stat st;
+        if (::fstat(fd.Get(), &st) == 0) {
+            FileStamp stamp{static_cast<uint64_t>(st.st_size),
+                            static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec};
+            auto checkpoint = indexes->Get(path, stamp)->Seek(fd.Get(), first);
+            if (checkpoint) {
+                line = checkpoint->line;
+                offset = checkpoint->offset;
+            }
+        }
+
+        // Reading starts mid-file, so sniff the head separately.
+        if (offset > 0) {
+            ssize_t n = ReadAt(fd.Get(), block.data(), kSniffBytes, 0);
+            if (n < 0) return std::unexpected("Failed to read file: " + path);
+            if (LooksBinary(std::string_view(block.data(), n), static_cast<size_t>(n) == kSniffBytes)) {
+                excerpt.binary = true;
+                return excerpt;
+            }
+        }
+    }
+
+    while (line < end && excerpt.text.size() < kMaxExcerptBytes) {
+        ssize_t n = ReadAt(fd.Get(), block.data(), block.size(), offset);
+        if (n < 0) return std::unexpected("Failed to read file: " + path);
+        if (n == 0) break;
+
+        std::string_view data(block.data(), static_cast<size_t>(n));
+        if (offset == 0) {
+            std::string_view head = data.substr(0, kSniffBytes);
+            if (LooksBinary(head, data.size() > head.size())) {
+                excerpt.binary = true;
+                return excerpt;
+            }
+        }
+
+        size_t pos = 0;
+        while (pos < data.size() && line < end) {
+            const void* newline = std::memchr(data.data() + pos, '\n', data.size() - pos);
+            size_t lineEnd = newline ? static_cast<const char*>(newline) - data.data() + 1 : data.size();
+            if (line >= first) {
+                excerpt.text.append(data.substr(pos, lineEnd - pos));
+            }
+            if (newline) ++line;
+            pos = lineEnd;
+        }
+        offset += n;
+    }
+    return excerpt;
+}
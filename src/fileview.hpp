@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Bytes at the start of a file inspected to tell text from binary.
+constexpr size_t kSniffBytes = 4096;
+
+// True if the head of a file holds a NUL byte or is not valid UTF-8. When
+// `truncated`, head was cut from a longer file and a multi-byte sequence split
+// at its end does not count as invalid.
+bool LooksBinary(std::string_view head, bool truncated);
+
+// Number of '\n' bytes in [data, data + size).
+size_t CountNewlines(const char* data, size_t size);
+
+// What the index cache knows about a file's contents: an index built for one
+// stamp is stale once the file's size or mtime changes.
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+
+    bool operator==(const FileStamp&) const = default;
+};
+
+// Sparse line-offset index of one file: the byte offset of every kStride-th
+// line. It is extended lazily, only as far into the file as lines are asked
+// for, so a window at any depth costs one seek plus at most kStride lines.
+class LineIndex
+{
+public:
+    static constexpr size_t kStride = 1024;
+
+    struct Checkpoint {
+        size_t line = 1;        // 1-based line starting at offset
+        uint64_t offset = 0;
+    };
+
+    explicit LineIndex(FileStamp stamp) : m_stamp(stamp) {}
+
+    // The last checkpoint at or before 1-based `line`, scanning further into
+    // the file through fd if the index does not reach that far yet.
+    std::expected<Checkpoint, std::string> Seek(int fd, size_t line);
+
+    const FileStamp& Stamp() const { return m_stamp; }
+    size_t Checkpoints() const;
+    size_t HeapBytes() const;
+
+private:
+    const FileStamp m_stamp;
+    mutable std::mutex m_mutex;
+    std::vector<uint64_t> m_offsets{0};   // m_offsets[k]: offset of line k * kStride + 1
+    uint64_t m_scanned = 0;               // Bytes indexed so far
+    uint64_t m_newlines = 0;              // Newlines within those bytes
+    bool m_complete = false;              // Indexed up to end of file
+};
+
+// Line indexes of the most recently previewed files, keyed by path. Safe to
+// use from several preview threads.
+class LineIndexCache
+{
+public:
+    static constexpr size_t kMaxFiles = 16;
+
+    // The index for path, replaced by an empty one if the file changed since.
+    std::shared_ptr<LineIndex> Get(const std::string& path, FileStamp stamp);
+
+    void Clear();
+    size_t Size() const;
+    size_t HeapBytes() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<LineIndex> index;
+        uint64_t lastUse = 0;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    uint64_t m_tick = 0;
+};
+
+struct FileExcerpt {
+    std::string text;       // The requested lines, newlines kept as in the file
+    bool binary = false;    // Set, with no text, when the file looks binary
+};
+
+// Reads `count` lines starting at 1-based line `first`, without spawning any
+// helper. Only the bytes up to the end of the window are read; lines past the
+// end of the file are simply absent. With `indexes`, windows deeper than one
+// stride start from the file's cached line index instead of its first byte.
+std::expected<FileExcerpt, std::string> ReadFileLines(const std::string& path, size_t first, size_t count,
+                                                      LineIndexCache* indexes = nullptr);
@@ -0,0 +1,74 @@
+#include "headless.hpp"
+#include "search.hpp"
+#include "template.hpp"
+
+#include <numeric>
+
+namespace {
+
+// Collects output lines and hands them to stdio in large writes.
+class OutputBuffer
+{
+public:
+    static constexpr size_t kFlushSize = 1 << 20;
+
+    explicit OutputBuffer(std::FILE* out) : m_out(out) { m_buffer.reserve(kFlushSize + 4096); }
+
+    void AppendLine(std::string_view line)
+    {
+        m_buffer.append(line);
+        m_buffer += '\n';
+        if (m_buffer.size() >= kFlushSize) Flush();
+    }
+
+    bool Flush()
+    {
+        if (!m_buffer.empty() && std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_out) != m_buffer.size()) {
+            m_failed = true;
+        }
+        m_buffer.clear();
+        return !m_failed;
+    }
+
+    bool Failed() const { return m_failed; }
+
+private:
+    std::FILE* m_out;
+    std::string m_buffer;
+    bool m_failed = false;
+};
+
+}
+
+int RunHeadless(const RowTable& lines, const HeadlessOptions& options, std::FILE* out)
+{
+    OutputBuffer output(out);
+    const CompiledTemplate viewTemplate(options.viewTemplate);
+
+    if (options.query.empty()) {
+        std::string line;
+        for (const auto& row : lines.data) {
+            line.clear();
+            viewTemplate.RenderInto(line, row);
+            output.AppendLine(line);
+        }
+        output.Flush();
+        if (output.Failed() || std::fflush(out) != 0) return 2;
+        return lines.data.empty() ? 1 : 0;
+    }
+
+    // Same labels the interactive search matches against: the rendered view.
+    const std::vector<std::string> labels = lines.GetMenuEntries(viewTemplate);
+    std::vector<size_t> candidates(labels.size());
+    std::iota(candidates.begin(), candidates.end(), 0);
+
+    const std::vector<size_t> ranked = RankMatches(options.query, labels, candidates);
+    for (size_t origIdx : ranked) {
+        output.AppendLine(labels[origIdx]);
+        if (output.Failed()) break;
+    }
+    output.Flush();
+
+    if (output.Failed() || std::fflush(out) != 0) return 2;
+    return ranked.empty() ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#include "RowTable.hpp"
+
+struct HeadlessOptions {
+    std::string query;
+    std::string viewTemplate = "{}";
+};
+
+// `fxf --filter`: ranks rows against the query exactly like interactive search
+// and writes the matches, rendered with the view template, one per line. No
+// terminal UI is created. Returns the process exit code: 0 when something
+// matched, 1 when nothing did, 2 on a write error.
+int RunHeadless(const RowTable& lines, const HeadlessOptions& options, std::FILE* out);
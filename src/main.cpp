@@ -1,31 +1,112 @@
 #include <iostream>
+#include <optional>
 #include <unistd.h>
 #include <CLI/CLI.hpp>
 
 #include "app.hpp"
+#include "headless.hpp"
+#include "perf.hpp"
+#include "trace.hpp"
 
 using namespace ftxui;
 
+// --filter: load the input and print ranked matches without creating the UI.
+static int RunFilter(const std::string& filename, char delimiter, bool stdin_is_pipe, const HeadlessOptions& options)
+{
+    RowTable lines;
+    if (!filename.empty()) {
+        if (auto result = lines.Load(filename, delimiter); !result) {
+            std::cerr << "Error: " << result.error() << "\n";
+            return 2;
+        }
+    } else if (stdin_is_pipe) {
+        std::ios::sync_with_stdio(false);
+        for (std::string line; std::getline(std::cin, line);) {
+            lines.AddLine(line, delimiter);
+        }
+    } else {
+        std::cerr << "Error: No input provided. Provide a file or pipe data.\n";
+        return 2;
+    }
+
+    return RunHeadless(lines, options, stdout);
+}
+
+// --trace: stop recording and write the timeline, if one was requested.
+static void WriteTrace(const std::string& path)
+{
+    if (path.empty()) return;
+    Trace::Stop();
+    if (!Trace::WriteJson(path.c_str())) {
+        std::cerr << "Error: Cannot write trace to " << path << "\n";
+    }
+}
+
 int main(int argc, char* argv[]) {
 
-    App& app = App::Instance();
     CLI::App args{"fxf - interactive text picker"};
 
     std::string filename;
     char delimiter = '|';
+    std::optional<std::string> filterQuery;
+    std::string viewTemplate;
+    bool perfHud = false;
+    std::string tracePath;
+    bool memReport = false;
+    size_t previewCacheMb = PreviewCache::kDefaultBudget >> 20;
+    std::string previewCacheDir;
+    std::string previewCommand;
+    std::string previewHelper;
     args.add_option("file", filename, "File to read (optional if piping data)");
     args.add_option("-d,--delimiter", delimiter, "Delimiter");
+    args.add_option("-f,--filter", filterQuery, "Print rows matching the query, best first, and exit without the UI");
+    args.add_option("--view", viewTemplate, "View template, e.g. \"{0} {2}\"");
+    args.add_option("--trace", tracePath, "Record a timeline and write it as Chrome trace-event JSON on exit");
+    args.add_flag("--mem-report", memReport, "Print a per-subsystem memory breakdown to stderr on exit");
+    args.add_option("--preview-cache-mb", previewCacheMb, "Memory budget for rendered previews, in MiB");
+    args.add_option("--preview-cache", previewCacheDir, "Directory to keep file and grep-match previews in between sessions");
+    args.add_option("--preview-cmd", previewCommand, "Command rendering a row's preview, e.g. \"bat --color=never {0}\"");
+    args.add_option("--preview-helper", previewHelper, "Long-lived command answering preview requests over stdin/stdout (see README)");
+    args.add_flag("--perf", perfHud, "Time load, search, render... and show latencies in the status bar");
 
     CLI11_PARSE(args, argc, argv);
 
     bool stdin_is_pipe = !isatty(STDIN_FILENO);
     bool stdout_is_pipe = !isatty(STDOUT_FILENO);
 
+    if (!tracePath.empty()) {
+        Trace::Start();
+        Trace::SetThreadName("main");
+    }
+
+    if (filterQuery) {
+        HeadlessOptions options{.query = *filterQuery};
+        if (!viewTemplate.empty()) options.viewTemplate = viewTemplate;
+        int rc = RunFilter(filename, delimiter, stdin_is_pipe, options);
+        WriteTrace(tracePath);
+        return rc;
+    }
+
+    App& app = App::Instance();
+    app.SetPerfHud(perfHud);
+    app.scope.SetCacheBudget(previewCacheMb << 20);
+    app.controls.previewCommand = previewCommand;
+    app.scope.SetPreviewHelper(previewHelper);
+    if (!previewCacheDir.empty()) {
+        if (auto result = app.scope.OpenDiskCache(previewCacheDir); !result) {
+            std::cerr << "Error: " << result.error() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
     // If stdin is a pipe, read data from it
     if (stdin_is_pipe) {
-        std::string line;
-        while (std::getline(std::cin, line)) {
-            app.state.lines.AddLine(line, delimiter);
+        {
+            ScopedTimer timer(PerfStage::Load);
+            std::string line;
+            while (std::getline(std::cin, line)) {
+                app.state.lines.AddLine(line, delimiter);
+            }
         }
 
         // Reopen stdin from /dev/tty for keyboard input
@@ -59,7 +140,7 @@ int main(int argc, char* argv[]) {
     } else if (stdin_is_pipe) {
         // Data already loaded from pipe, initialize filter
         app.controls.viewTemplate = "{}";
-        app.ResetFilter();
+        app.ResetView();
         app.controls.selected = 0;
     } else {
         // No input provided
@@ -67,6 +148,10 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
+    if (!viewTemplate.empty()) {
+        app.ApplyViewTemplate(viewTemplate);
+    }
+
     app.Loop();
 
     // Restore stdout if it was redirected
@@ -80,5 +165,11 @@ int main(int argc, char* argv[]) {
         std::cout << app.state.output << std::endl;
     }
 
+    if (memReport) {
+        std::cerr << app.MemoryReport();
+    }
+
+    WriteTrace(tracePath);
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,77 @@
+#include "memory.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+size_t HeapBytes(const std::vector<std::string>& strings)
+{
+    size_t bytes = strings.capacity() * sizeof(std::string);
+    for (const std::string& str : strings) bytes += HeapBytes(str);
+    return bytes;
+}
+
+size_t HeapBytes(const RowTable& table)
+{
+    size_t bytes = table.data.capacity() * sizeof(RowTable::row_t);
+    for (const auto& row : table.data) bytes += HeapBytes(row);
+    return bytes;
+}
+
+size_t FieldCount(const RowTable& table)
+{
+    size_t fields = 0;
+    for (const auto& row : table.data) fields += row.size();
+    return fields;
+}
+
+std::optional<size_t> ResidentBytes()
+{
+    // statm: total and resident size in pages
+    std::ifstream statm("/proc/self/statm");
+    size_t total = 0;
+    size_t resident = 0;
+    if (!(statm >> total >> resident)) return std::nullopt;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+std::string FormatBytes(size_t bytes)
+{
+    static constexpr const char* kUnits[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    double value = static_cast<double>(bytes);
+    size_t unit = 0;
+    while (value >= 1024 && unit + 1 < std::size(kUnits)) {
+        value /= 1024;
+        ++unit;
+    }
+
+    char buf[32];
+    if (unit == 0) std::snprintf(buf, sizeof buf, "%zu B", bytes);
+    else std::snprintf(buf, sizeof buf, "%.1f %s", value, kUnits[unit]);
+    return buf;
+}
+
+std::string FormatMemoryReport(std::span<const MemoryEntry> entries)
+{
+    std::string report;
+    char line[160];
+    std::snprintf(line, sizeof line, "%-22s %12s %12s %10s\n", "subsystem", "count", "bytes", "avg");
+    report += line;
+
+    size_t total = 0;
+    for (const MemoryEntry& entry : entries) {
+        total += entry.bytes;
+        std::string average = entry.count > 0 ? FormatBytes(entry.bytes / entry.count) : "-";
+        std::snprintf(line, sizeof line, "%-22s %12zu %12s %10s\n",
+                      entry.name.c_str(), entry.count, FormatBytes(entry.bytes).c_str(), average.c_str());
+        report += line;
+    }
+
+    std::snprintf(line, sizeof line, "%-22s %12s %12s\n", "total", "", FormatBytes(total).c_str());
+    report += line;
+    if (auto resident = ResidentBytes()) {
+        std::snprintf(line, sizeof line, "%-22s %12s %12s\n", "process resident", "", FormatBytes(*resident).c_str());
+        report += line;
+    }
+    return report;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "RowTable.hpp"
+
+// Approximate heap accounting for the memory report (`mem`, --mem-report).
+// Sizes are what the containers have reserved, not allocator overhead.
+
+struct MemoryEntry {
+    std::string name;
+    size_t count = 0;   // Items held: rows, entries, bits...
+    size_t bytes = 0;   // Heap bytes, plus inline storage of those items
+};
+
+// Heap bytes owned by a string: 0 while it fits the small-string buffer.
+inline size_t HeapBytes(const std::string& str)
+{
+    static const size_t inlineCapacity = std::string().capacity();
+    return str.capacity() > inlineCapacity ? str.capacity() + 1 : 0;
+}
+
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+size_t HeapBytes(const std::vector<T>& values)
+{
+    return values.capacity() * sizeof(T);
+}
+
+size_t HeapBytes(const std::vector<std::string>& strings);
+size_t HeapBytes(const RowTable& table);
+
+// Total fields over all rows
+size_t FieldCount(const RowTable& table);
+
+// Resident set size of this process, where the platform reports it.
+std::optional<size_t> ResidentBytes();
+
+// "12.3 MiB"
+std::string FormatBytes(size_t bytes);
+
+// One line per entry with count, bytes and bytes per item, then the total.
+std::string FormatMemoryReport(std::span<const MemoryEntry> entries);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <ftxui/util/ref.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The labels the menu shows, one per display position. Either owned (rendered
+// for the current view) or an index view over labels stored elsewhere, so a
+// search result can be shown without copying any label.
+class MenuEntries : public ftxui::ConstStringListRef::Adapter
+{
+public:
+    // Switches to owned labels and returns them resized to `count`. Existing
+    // strings keep their capacity, so re-rendering reuses their storage.
+    std::vector<std::string>& Owned(size_t count)
+    {
+        m_labels = nullptr;
+        m_indices = nullptr;
+        m_owned.resize(count);
+        return m_owned;
+    }
+
+    // Shows labels[indices[i]] at position i. Both vectors are referenced, not
+    // copied, and must outlive this view or the next Owned()/Index() call.
+    void Index(const std::vector<std::string>& labels, const std::vector<size_t>& indices)
+    {
+        m_labels = &labels;
+        m_indices = &indices;
+    }
+
+    size_t size() const override { return m_indices ? m_indices->size() : m_owned.size(); }
+    bool empty() const { return size() == 0; }
+
+    std::string_view View(size_t i) const
+    {
+        return m_indices ? std::string_view((*m_labels)[(*m_indices)[i]]) : std::string_view(m_owned[i]);
+    }
+
+    std::string operator[](size_t i) const override { return std::string(View(i)); }
+    std::string front() const { return (*this)[0]; }
+
+    void clear() { Owned(0); }
+
+    // Storage kept for owned labels, also while an index view is shown
+    const std::vector<std::string>& OwnedLabels() const { return m_owned; }
+
+private:
+    std::vector<std::string> m_owned;
+    const std::vector<std::string>* m_labels = nullptr;
+    const std::vector<size_t>* m_indices = nullptr;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+// Threads used by the data-parallel helpers below.
+inline size_t WorkerCount()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Number of chunks ParallelFor splits n items into, each at least minChunk long.
+inline size_t ChunkCount(size_t n, size_t minChunk)
+{
+    if (n == 0) return 0;
+    return std::clamp<size_t>(n / std::max<size_t>(minChunk, 1), 1, WorkerCount());
+}
+
+// Splits [0, n) into ChunkCount() contiguous chunks and runs fn(begin, end, chunk)
+// for each on its own thread. Chunks are in ascending order of `chunk`, so
+// per-chunk results can be concatenated to preserve input order. Small inputs
+// run inline on the calling thread.
+template <typename Fn>
+void ParallelFor(size_t n, size_t minChunk, Fn&& fn)
+{
+    const size_t chunks = ChunkCount(n, minChunk);
+    if (chunks <= 1) {
+        if (n > 0) fn(size_t{0}, n, size_t{0});
+        return;
+    }
+
+    std::vector<std::jthread> threads;
+    threads.reserve(chunks - 1);
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        threads.emplace_back([&fn, n, chunks, chunk] {
+            fn(n * chunk / chunks, n * (chunk + 1) / chunks, chunk);
+        });
+    }
+    fn(size_t{0}, n / chunks, size_t{0});
+}
+
+// Sorts [first, last) by sorting one chunk per worker and merging pairs of
+// sorted runs in parallel rounds. Not stable; make comp a total order for a
+// deterministic result.
+template <typename RandomIt, typename Compare>
+void ParallelSort(RandomIt first, RandomIt last, Compare comp, size_t minChunk = 1 << 16)
+{
+    const size_t n = static_cast<size_t>(std::distance(first, last));
+    const size_t chunks = ChunkCount(n, minChunk);
+    if (chunks <= 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t chunk = 0; chunk <= chunks; ++chunk) {
+        bounds[chunk] = n * chunk / chunks;
+    }
+
+    ParallelFor(chunks, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            std::sort(first + bounds[chunk], first + bounds[chunk + 1], comp);
+        }
+    });
+
+    // Each round merges runs [i, i + width) and [i + width, i + 2 * width).
+    for (size_t width = 1; width < chunks; width *= 2) {
+        const size_t pairs = (chunks + 2 * width - 1) / (2 * width);
+        ParallelFor(pairs, 1, [&](size_t begin, size_t end, size_t) {
+            for (size_t pair = begin; pair < end; ++pair) {
+                size_t lo = pair * 2 * width;
+                size_t mid = std::min(lo + width, chunks);
+                size_t hi = std::min(lo + 2 * width, chunks);
+                if (mid < hi) {
+                    std::inplace_merge(first + bounds[lo], first + bounds[mid], first + bounds[hi], comp);
+                }
+            }
+        });
+    }
+}
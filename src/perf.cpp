@@ -0,0 +1,130 @@
+#include "perf.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+
+std::string_view PerfStageName(PerfStage stage)
+{
+    switch (stage) {
+        case PerfStage::Load:    return "load";
+        case PerfStage::Search:  return "search";
+        case PerfStage::Extract: return "extract";
+        case PerfStage::Sort:    return "sort";
+        case PerfStage::Filter:  return "where";
+        case PerfStage::View:    return "view";
+        case PerfStage::Preview: return "preview";
+        case PerfStage::Frame:   return "frame";
+        case PerfStage::Count:   break;
+    }
+    return "";
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t ns)
+{
+    if (ns < kSubBuckets) return static_cast<size_t>(ns);
+    // Exponent picks the power of two, the next two bits below the leading one the sub-bucket.
+    size_t exponent = std::bit_width(ns) - 1;
+    size_t sub = static_cast<size_t>(ns >> (exponent - 2)) & (kSubBuckets - 1);
+    return (exponent - 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index)
+{
+    if (index < kSubBuckets) return index;
+    size_t exponent = index / kSubBuckets + 1;
+    uint64_t sub = index % kSubBuckets;
+    uint64_t next = (kSubBuckets + sub + 1) << (exponent - 2);
+    return next == 0 ? UINT64_MAX : next - 1;
+}
+
+void LatencyHistogram::Record(uint64_t ns)
+{
+    m_buckets[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_last.store(ns, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::Reset()
+{
+    for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_last.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const
+{
+    // Sum the buckets rather than trusting m_count, which may run ahead of
+    // them while another thread is recording.
+    uint64_t total = 0;
+    for (const auto& bucket : m_buckets) total += bucket.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p / 100.0 * total)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(BucketUpperBound(i), Max());
+    }
+    return Max();
+}
+
+LatencyHistogram& Perf::Histogram(PerfStage stage)
+{
+    static std::array<LatencyHistogram, static_cast<size_t>(PerfStage::Count)> histograms;
+    return histograms[static_cast<size_t>(stage)];
+}
+
+void Perf::Reset()
+{
+    for (size_t i = 0; i < static_cast<size_t>(PerfStage::Count); ++i) {
+        Histogram(static_cast<PerfStage>(i)).Reset();
+    }
+}
+
+std::string Perf::Summary()
+{
+    std::string summary;
+    for (size_t i = 0; i < static_cast<size_t>(PerfStage::Count); ++i) {
+        auto stage = static_cast<PerfStage>(i);
+        const LatencyHistogram& histogram = Histogram(stage);
+        if (histogram.Count() == 0) continue;
+
+        if (!summary.empty()) summary += "  ";
+        summary += PerfStageName(stage);
+        summary += ' ';
+        summary += FormatDuration(histogram.Last());
+        summary += '/';
+        summary += FormatDuration(histogram.Percentile(99));
+    }
+    return summary.empty() ? "no samples" : summary;
+}
+
+void RecordSpan(PerfStage stage, Trace::clock::time_point start, Trace::clock::time_point end,
+                const char* argName, uint64_t arg)
+{
+    if (Perf::Enabled()) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        Perf::Record(stage, static_cast<uint64_t>(elapsed.count()));
+    }
+    if (Trace::Enabled()) {
+        // Stage names are literals, so data() is null-terminated.
+        Trace::Complete(PerfStageName(stage).data(), start, end, argName, arg);
+    }
+}
+
+std::string FormatDuration(uint64_t ns)
+{
+    char buf[32];
+    if (ns < 1'000) std::snprintf(buf, sizeof buf, "%lluns", static_cast<unsigned long long>(ns));
+    else if (ns < 1'000'000) std::snprintf(buf, sizeof buf, "%.0fus", ns / 1e3);
+    else if (ns < 10'000'000) std::snprintf(buf, sizeof buf, "%.1fms", ns / 1e6);
+    else if (ns < 1'000'000'000) std::snprintf(buf, sizeof buf, "%.0fms", ns / 1e6);
+    else std::snprintf(buf, sizeof buf, "%.2fs", ns / 1e9);
+    return buf;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "trace.hpp"
+
+// Latency instrumentation for the hot paths. Timers are off by default; while
+// off (and not tracing), a ScopedTimer costs two relaxed atomic loads.
+
+enum class PerfStage {
+    Load,       // RowTable::Load
+    Search,     // One search update: ranking plus the menu refresh
+    Extract,    // Fuzzy scoring inside a search
+    Sort,       // SortIndices
+    Filter,     // FilterIndices
+    View,       // Rebuilding menu entries (UpdateFilteredView/RefreshFilteredView)
+    Preview,    // Scope::Process
+    Frame,      // Building, laying out and drawing one frame
+    Count
+};
+
+std::string_view PerfStageName(PerfStage stage);
+
+// Log-linear histogram of durations in nanoseconds: four buckets per power of
+// two, so percentiles are within 25%. Safe to record from any thread.
+class LatencyHistogram
+{
+public:
+    static constexpr size_t kSubBuckets = 4;
+    static constexpr size_t kBucketCount = 64 * kSubBuckets;
+
+    void Record(uint64_t ns);
+    void Reset();
+
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t Last() const { return m_last.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return m_max.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the p-th percentile (0-100), capped at Max().
+    uint64_t Percentile(double p) const;
+
+    static size_t BucketIndex(uint64_t ns);
+    static uint64_t BucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_last{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+class Perf
+{
+public:
+    static bool Enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+
+    static LatencyHistogram& Histogram(PerfStage stage);
+    static void Record(PerfStage stage, uint64_t ns) { Histogram(stage).Record(ns); }
+    static void Reset();
+
+    // "search 1.2ms/3.4ms extract ..." with last/p99 for every stage that has samples.
+    static std::string Summary();
+
+private:
+    static inline std::atomic<bool> s_enabled{false};
+};
+
+// "850ns", "12us", "3.4ms", "1.25s"
+std::string FormatDuration(uint64_t ns);
+
+// Records [start, end) into the stage's histogram when Perf is enabled and as
+// a trace span (with an optional numeric argument) when tracing.
+void RecordSpan(PerfStage stage, Trace::clock::time_point start, Trace::clock::time_point end,
+                const char* argName = nullptr, uint64_t arg = 0);
+
+// Records the lifetime of the scope with RecordSpan.
+class ScopedTimer
+{
+public:
+    using clock = Trace::clock;
+
+    explicit ScopedTimer(PerfStage stage, const char* argName = nullptr, uint64_t arg = 0)
+        : m_stage(stage)
+        , m_active(Perf::Enabled() || Trace::Enabled())
+        , m_argName(argName)
+        , m_arg(arg)
+    {
+        if (m_active) m_start = clock::now();
+    }
+
+    ~ScopedTimer()
+    {
+        if (m_active) RecordSpan(m_stage, m_start, clock::now(), m_argName, m_arg);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    PerfStage m_stage;
+    bool m_active;
+    const char* m_argName;
+    uint64_t m_arg;
+    clock::time_point m_start;
+};
@@ -0,0 +1,108 @@
+#include "preview_cache.hpp"
+
+namespace {
+
+size_t Hash(std::string_view key) { return std::hash<std::string_view>{}(key); }
+
+}
+
+size_t PreviewCache::ShardIndex(std::string_view key)
+{
+    return ShardOf(Hash(key));
+}
+
+size_t PreviewCache::Charge(std::string_view key, std::string_view value)
+{
+    // A list node (two links and the entry), an index node (link, key,
+    // iterator and cached hash) and the shared value's control block and string.
+    constexpr size_t overhead = 2 * sizeof(void*) + sizeof(Entry)
+                              + 2 * sizeof(void*) + sizeof(Key) + sizeof(std::list<Entry>::iterator)
+                              + 2 * sizeof(void*) + sizeof(std::string);
+    return overhead + key.size() + value.size();
+}
+
+PreviewCache::Value PreviewCache::Lookup(std::string_view key)
+{
+    const size_t hash = Hash(key);
+    Shard& shard = ShardFor(hash);
+
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.index.find(Key{hash, key});
+    if (it == shard.index.end()) return nullptr;
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->value;
+}
+
+void PreviewCache::Insert(std::string_view key, std::string value)
+{
+    const size_t hash = Hash(key);
+    const size_t charge = Charge(key, value);
+    Shard& shard = ShardFor(hash);
+    auto shared = std::make_shared<const std::string>(std::move(value));
+
+    std::lock_guard lock(shard.mutex);
+    if (auto it = shard.index.find(Key{hash, key}); it != shard.index.end()) {
+        shard.bytes -= it->second->charge;
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+
+    const size_t limit = ShardBudget();
+    if (charge > limit) return;
+
+    EvictTo(shard, limit - charge);
+    shard.lru.push_front(Entry{std::string(key), std::move(shared), hash, charge});
+    shard.index.emplace(Key{hash, shard.lru.front().key}, shard.lru.begin());
+    shard.bytes += charge;
+}
+
+void PreviewCache::EvictTo(Shard& shard, size_t limit)
+{
+    while (shard.bytes > limit && !shard.lru.empty()) {
+        const Entry& oldest = shard.lru.back();
+        shard.index.erase(Key{oldest.hash, oldest.key});
+        shard.bytes -= oldest.charge;
+        shard.lru.pop_back();
+    }
+}
+
+void PreviewCache::Clear()
+{
+    for (Shard& shard : m_shards) {
+        std::lock_guard lock(shard.mutex);
+        shard.index.clear();
+        shard.lru.clear();
+        shard.bytes = 0;
+    }
+}
+
+void PreviewCache::SetBudget(size_t bytes)
+{
+    m_budget.store(bytes, std::memory_order_relaxed);
+    const size_t limit = ShardBudget();
+    for (Shard& shard : m_shards) {
+        std::lock_guard lock(shard.mutex);
+        EvictTo(shard, limit);
+    }
+}
+
+size_t PreviewCache::Entries() const
+{
+    size_t entries = 0;
+    for (const Shard& shard : m_shards) {
+        std::lock_guard lock(shard.mutex);
+        entries += shard.lru.size();
+    }
+    return entries;
+}
+
+size_t PreviewCache::Bytes() const
+{
+    size_t bytes = 0;
+    for (const Shard& shard : m_shards) {
+        std::lock_guard lock(shard.mutex);
+        bytes += shard.bytes;
+    }
+    return bytes;
+}
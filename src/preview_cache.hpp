@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Thread-safe LRU of rendered previews, bounded by bytes rather than entries.
+// Keys are spread by hash over kShards shards, each with its own lock, LRU
+// list and an equal share of the budget. A key is hashed once per call and
+// looked up as a string_view; it is only copied when inserted.
+class PreviewCache
+{
+public:
+    using Value = std::shared_ptr<const std::string>;
+
+    static constexpr size_t kShards = 16;
+    static constexpr size_t kDefaultBudget = size_t{64} << 20;
+
+    explicit PreviewCache(size_t budget = kDefaultBudget) : m_budget(budget) {}
+
+    // The cached value, marked most recently used; null on a miss.
+    Value Lookup(std::string_view key);
+
+    // Adds or replaces key, evicting least recently used entries of its shard
+    // to stay within budget. A value larger than a shard's share is not kept.
+    void Insert(std::string_view key, std::string value);
+
+    void Clear();
+
+    // Evicts down to a new budget right away.
+    void SetBudget(size_t bytes);
+    size_t Budget() const { return m_budget.load(std::memory_order_relaxed); }
+
+    size_t Entries() const;
+    size_t Bytes() const;   // Charged against the budget
+
+    // Shard a key is stored in; each holds Budget() / kShards bytes.
+    static size_t ShardIndex(std::string_view key);
+
+    // What one entry is charged: key, value and bookkeeping.
+    static size_t Charge(std::string_view key, std::string_view value);
+
+private:
+    struct Entry {
+        std::string key;
+        Value value;
+        size_t hash;
+        size_t charge;
+    };
+
+    // Views the key stored in the entry, with its hash precomputed.
+    struct Key {
+        size_t hash;
+        std::string_view text;
+        bool operator==(const Key& other) const { return hash == other.hash && text == other.text; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return key.hash; }
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru;   // Most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        size_t bytes = 0;
+    };
+
+    // Folds in the upper half of the hash, which the shard's own map ignores;
+    // the shift is half the width of size_t, so it is defined on 32-bit too.
+    static size_t ShardOf(size_t hash) { return (hash ^ (hash >> (sizeof(size_t) * 4))) % kShards; }
+    Shard& ShardFor(size_t hash) { return m_shards[ShardOf(hash)]; }
+    size_t ShardBudget() const { return Budget() / kShards; }
+    static void EvictTo(Shard& shard, size_t limit);
+
+    std::atomic<size_t> m_budget;
+    std::array<Shard, kShards> m_shards;
+};
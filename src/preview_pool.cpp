@@ -0,0 +1,161 @@
+#include "preview_pool.hpp"
+#include "perf.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+PreviewPool::PreviewPool(size_t threads)
+    : m_slots(std::max<size_t>(threads, 1))
+{
+    m_threads.reserve(m_slots.size());
+    for (size_t slot = 0; slot < m_slots.size(); ++slot) {
+        m_threads.emplace_back([this, slot](std::stop_token poolStop) { Work(poolStop, slot); });
+    }
+}
+
+PreviewPool::~PreviewPool()
+{
+    Cancel();
+    for (auto& thread : m_threads) thread.request_stop();
+}
+
+void PreviewPool::Submit(Job job)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        ++m_stats.submitted;
+        if (m_pending) ++m_stats.superseded;
+        m_pending = std::move(job);
+        StopRunning(false);
+
+        // Make room if speculative work holds every worker.
+        if (std::ranges::all_of(m_slots, &Slot::busy)) StopRunning(true);
+    }
+    m_wake.notify_one();
+}
+
+void PreviewPool::Prefetch(std::vector<Job> jobs)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stats.submitted += jobs.size();
+        m_stats.superseded += m_prefetch.size();
+        m_prefetch.assign(std::make_move_iterator(jobs.begin()), std::make_move_iterator(jobs.end()));
+    }
+    m_wake.notify_all();
+}
+
+void PreviewPool::CancelRequest()
+{
+    std::lock_guard lock(m_mutex);
+    if (m_pending) {
+        ++m_stats.superseded;
+        m_pending.reset();
+    }
+    StopRunning(false);
+    if (Idle()) m_idle.notify_all();
+}
+
+void PreviewPool::CancelPrefetch()
+{
+    std::lock_guard lock(m_mutex);
+    m_stats.superseded += m_prefetch.size();
+    m_prefetch.clear();
+    StopRunning(true);
+    if (Idle()) m_idle.notify_all();
+}
+
+void PreviewPool::Cancel()
+{
+    std::lock_guard lock(m_mutex);
+    m_stats.superseded += m_prefetch.size() + (m_pending ? 1 : 0);
+    m_prefetch.clear();
+    m_pending.reset();
+    StopRunning(false);
+    StopRunning(true);
+    if (Idle()) m_idle.notify_all();
+}
+
+void PreviewPool::StopRunning(bool prefetch)
+{
+    for (Slot& slot : m_slots) {
+        if (slot.busy && slot.prefetch == prefetch) slot.stop.request_stop();
+    }
+}
+
+bool PreviewPool::Idle() const
+{
+    return !m_pending && m_prefetch.empty() && std::ranges::none_of(m_slots, &Slot::busy);
+}
+
+void PreviewPool::WaitIdle()
+{
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this] { return Idle(); });
+}
+
+void PreviewPool::Work(std::stop_token poolStop, size_t slotIndex)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::unique_lock lock(m_mutex);
+    while (m_wake.wait(lock, poolStop, [this] { return m_pending || !m_prefetch.empty(); })) {
+        Slot& slot = m_slots[slotIndex];
+        Job job;
+        if (m_pending) {
+            job = std::move(*m_pending);
+            m_pending.reset();
+            slot.prefetch = false;
+        } else {
+            job = std::move(m_prefetch.front());
+            m_prefetch.pop_front();
+            slot.prefetch = true;
+        }
+        slot.busy = true;
+        slot.stop = std::stop_source();
+        std::stop_token stop = slot.stop.get_token();
+        lock.unlock();
+
+        auto start = clock::now();
+        try {
+            job(stop);
+        } catch (...) {
+            // A failed render must not take the worker down with it
+        }
+        job = nullptr;
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+
+        lock.lock();
+        slot.busy = false;
+        if (stop.stop_requested()) {
+            ++m_stats.wasted;
+            m_stats.wastedNs += static_cast<uint64_t>(elapsed.count());
+        } else if (slot.prefetch) {
+            ++m_stats.prefetched;
+        } else {
+            ++m_stats.completed;
+        }
+        if (Idle()) m_idle.notify_all();
+    }
+}
+
+PreviewPoolStats PreviewPool::Stats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+void PreviewPool::ResetStats()
+{
+    std::lock_guard lock(m_mutex);
+    m_stats = {};
+}
+
+std::string PreviewPool::Summary() const
+{
+    PreviewPoolStats stats = Stats();
+    return "previews " + std::to_string(stats.completed)
+         + " prefetched " + std::to_string(stats.prefetched)
+         + " wasted " + std::to_string(stats.wasted)
+         + " (" + FormatDuration(stats.wastedNs) + ")";
+}
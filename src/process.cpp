@@ -0,0 +1,235 @@
+#include "process.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+// Reads start at kMinRead and grow with the output up to kMaxRead, so small
+// outputs stay small and large ones take few syscalls.
+constexpr size_t kMinRead = 64 * 1024;
+constexpr size_t kMaxRead = 1024 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+// Owns the posix_spawn attribute objects for one spawn.
+struct SpawnSetup {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+
+    SpawnSetup()
+    {
+        posix_spawn_file_actions_init(&actions);
+        posix_spawnattr_init(&attr);
+    }
+    ~SpawnSetup()
+    {
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attr);
+    }
+    SpawnSetup(const SpawnSetup&) = delete;
+    SpawnSetup& operator=(const SpawnSetup&) = delete;
+};
+
+// Kills the command: its whole process group (pipelines included) when it
+// has one of its own, else just the child.
+void KillChild(pid_t pid, const RunOptions& options)
+{
+    ::kill(options.newProcessGroup ? -pid : pid, SIGKILL);
+}
+
+// Reads the child's stdout from fd until EOF, a limit, or a stop. Anything
+// that ends the read early kills the child, which closes the pipe's other
+// write ends too when it had its own group. The stop callback is
+// unregistered on return, before the child is reaped, so it can never signal
+// a recycled pid.
+void ReadOutput(pid_t pid, int fd, const RunOptions& options, Clock::time_point deadline, RunResult& result)
+{
+    std::atomic<bool> stopped{false};
+    std::stop_callback onStop(options.stop, [pid, &options, &stopped] {
+        stopped = true;
+        KillChild(pid, options);
+    });
+
+    const bool timed = deadline != Clock::time_point::max();
+    std::string& out = result.output;
+
+    for (;;) {
+        if (timed) {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+            pollfd pfd{fd, POLLIN, 0};
+            int ready = left.count() > 0 ? ::poll(&pfd, 1, static_cast<int>(left.count())) : 0;
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready == 0) {
+                result.timedOut = true;
+                KillChild(pid, options);
+                break;
+            }
+        }
+
+        const size_t old = out.size();
+        const size_t want = std::clamp(old, kMinRead, kMaxRead);
+        ssize_t n = 0;
+        int readErrno = 0;
+        out.resize_and_overwrite(old + want, [&](char* data, size_t) {
+            n = ::read(fd, data + old, want);
+            readErrno = errno;
+            return old + static_cast<size_t>(std::max<ssize_t>(n, 0));
+        });
+        if (n < 0 && readErrno == EINTR) continue;
+        if (n <= 0) break;
+
+        size_t got = static_cast<size_t>(n);
+        bool capped = false;
+        if (options.maxOutput > 0 && out.size() >= options.maxOutput) {
+            got -= out.size() - options.maxOutput;
+            out.resize(options.maxOutput);
+            capped = true;
+        }
+
+        bool more = true;
+        if (options.onOutput && !stopped && got > 0) {
+            more = options.onOutput(std::string_view(out.data() + old, got));
+        }
+        if (capped || !more) {
+            result.truncated = true;
+            KillChild(pid, options);
+            break;
+        }
+    }
+
+    result.stopped = stopped;
+}
+
+// Waits for the child to exit. A child that closed its stdout but keeps
+// running is still held to the deadline and the stop token: it is polled
+// until either runs out, then killed. Until waitpid has reaped it the pid
+// cannot be reused, so the kill is safe.
+pid_t Reap(pid_t pid, const RunOptions& options, Clock::time_point deadline, RunResult& result, int& status)
+{
+    const bool bounded = options.captureOutput
+                      && (deadline != Clock::time_point::max() || options.stop.stop_possible());
+    if (bounded && !result.timedOut && !result.stopped) {
+        auto pause = std::chrono::microseconds(100);
+        for (;;) {
+            pid_t reaped = ::waitpid(pid, &status, WNOHANG);
+            if (reaped == pid) return reaped;
+            if (reaped == -1 && errno != EINTR) return reaped;
+
+            if (options.stop.stop_requested()) {
+                result.stopped = true;
+                KillChild(pid, options);
+                break;
+            }
+            auto now = Clock::now();
+            if (now >= deadline) {
+                result.timedOut = true;
+                KillChild(pid, options);
+                break;
+            }
+            std::this_thread::sleep_for(std::min<Clock::duration>(pause, deadline - now));
+            pause = std::min(pause * 2, std::chrono::microseconds(10'000));
+        }
+    }
+
+    pid_t reaped;
+    while ((reaped = ::waitpid(pid, &status, 0)) == -1 && errno == EINTR) {}
+    return reaped;
+}
+
+std::expected<RunResult, std::string> Spawn(const char* file, char* const argv[], const RunOptions& options)
+{
+    SpawnSetup setup;
+
+    // The child starts with no signals blocked and default SIGPIPE handling,
+    // whatever the spawning thread had.
+    sigset_t none, defaults;
+    sigemptyset(&none);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigmask(&setup.attr, &none);
+    posix_spawnattr_setsigdefault(&setup.attr, &defaults);
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+
+    int fds[2] = {-1, -1};
+    if (options.captureOutput) {
+        // O_CLOEXEC keeps the pipe out of children spawned on other threads.
+        if (::pipe2(fds, O_CLOEXEC) != 0) {
+            return std::unexpected(std::string("Failed to create pipe: ") + std::strerror(errno));
+        }
+        posix_spawn_file_actions_adddup2(&setup.actions, fds[1], STDOUT_FILENO);
+
+    }
+    if (options.captureOutput && options.newProcessGroup) {
+        posix_spawnattr_setpgroup(&setup.attr, 0);
+        flags |= POSIX_SPAWN_SETPGROUP;
+    }
+    if (options.discardStderr) {
+        posix_spawn_file_actions_addopen(&setup.actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    }
+    posix_spawnattr_setflags(&setup.attr, flags);
+
+    pid_t pid;
+    int rc = ::posix_spawnp(&pid, file, &setup.actions, &setup.attr, argv, environ);
+    if (fds[1] >= 0) ::close(fds[1]);
+    if (rc != 0) {
+        if (fds[0] >= 0) ::close(fds[0]);
+        return std::unexpected(std::string("Failed to run ") + file + ": " + std::strerror(rc));
+    }
+
+    const Clock::time_point deadline = options.captureOutput && options.timeout.count() > 0
+                                     ? Clock::now() + options.timeout
+                                     : Clock::time_point::max();
+    RunResult result;
+    if (options.captureOutput) {
+        ReadOutput(pid, fds[0], options, deadline, result);
+        ::close(fds[0]);
+    }
+
+    int status;
+    pid_t reaped = Reap(pid, options, deadline, result, status);
+
+    if (reaped != pid) {
+        // Already reaped elsewhere; the exit code is lost
+    } else if (WIFEXITED(status)) {
+        result.exitCode = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result.signal = WTERMSIG(status);
+    }
+    return result;
+}
+
+}
+
+std::expected<RunResult, std::string> RunProcess(const std::vector<std::string>& argv, const RunOptions& options)
+{
+    if (argv.empty()) return std::unexpected(std::string("Failed to run: empty command"));
+
+    std::vector<char*> args;
+    args.reserve(argv.size() + 1);
+    for (const auto& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    return Spawn(args[0], args.data(), options);
+}
+
+std::expected<RunResult, std::string> RunShell(const std::string& command, const RunOptions& options)
+{
+    char sh[] = "sh";
+    char dashC[] = "-c";
+    char* args[] = {sh, dashC, const_cast<char*>(command.c_str()), nullptr};
+    return Spawn("/bin/sh", args, options);
+}
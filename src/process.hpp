@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Runs child processes with posix_spawn, which glibc implements with
+// vfork semantics: the parent's page tables are shared rather than copied,
+// so starting a command costs the same however large fxf has grown.
+
+struct RunOptions {
+    // Capture stdout. Without capture the command shares our stdout and
+    // process group, as interactive programs need, and everything below
+    // except discardStderr is ignored.
+    bool captureOutput = true;
+    bool discardStderr = false;
+
+    // Run a captured command in a process group of its own, so a kill reaches
+    // every process of a pipeline. Such a group is in the background, where
+    // reading the terminal stops it, so commands that may prompt (sudo, ssh)
+    // should stay in fxf's group; kills then reach the child only.
+    bool newProcessGroup = true;
+
+    std::stop_token stop{};                 // Kills the command
+    std::chrono::milliseconds timeout{0};   // Kills it if still running after this long; 0 for no limit
+    size_t maxOutput = 0;                   // Kills it once this much is read; 0 for no limit
+
+    // Sees every block of output as it is read; returning false kills the command.
+    std::function<bool(std::string_view chunk)> onOutput{};
+};
+
+struct RunResult {
+    std::string output;         // Captured stdout, at most maxOutput bytes
+    int exitCode = -1;          // -1 if killed by a signal
+    int signal = 0;             // Signal that killed it, e.g. SIGKILL after a stop or timeout
+    bool stopped = false;       // Killed on a stop request
+    bool timedOut = false;
+    bool truncated = false;     // Killed at maxOutput or because onOutput declined more
+};
+
+// Runs argv[0] (searched in PATH) with argv, without a shell.
+std::expected<RunResult, std::string> RunProcess(const std::vector<std::string>& argv, const RunOptions& options = {});
+
+// Runs command through /bin/sh -c.
+std::expected<RunResult, std::string> RunShell(const std::string& command, const RunOptions& options = {});
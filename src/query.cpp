@@ -0,0 +1,326 @@
+#include "query.hpp"
+#include "parallel.hpp"
+#include "perf.hpp"
+
+#include <charconv>
+#include <array>
+#include <cmath>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+std::optional<size_t> ParseColumn(const std::string& arg)
+{
+    size_t column = 0;
+    auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), column);
+    if (ec != std::errc{} || ptr != arg.data() + arg.size()) return std::nullopt;
+    return column;
+}
+
+// Sorts (key, row) pairs and writes the rows back into indices.
+template <typename Key, typename Less>
+void SortByKey(std::vector<std::pair<Key, size_t>>& keyed, std::vector<size_t>& indices, Less less)
+{
+    ParallelSort(keyed.begin(), keyed.end(), [&](const auto& a, const auto& b) {
+        if (less(a.first, b.first)) return true;
+        if (less(b.first, a.first)) return false;
+        return a.second < b.second;
+    });
+
+    ParallelFor(keyed.size(), 1 << 16, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            indices[i] = keyed[i].second;
+        }
+    });
+}
+
+// Rows per batch: small enough that keys and the match mask stay in L1.
+constexpr size_t kBatchSize = 1024;
+
+std::optional<Predicate::Op> ParseOp(std::string_view op)
+{
+    if (op == "==" || op == "=") return Predicate::Op::Equal;
+    if (op == "!=") return Predicate::Op::NotEqual;
+    if (op == "<")  return Predicate::Op::Less;
+    if (op == "<=") return Predicate::Op::LessEqual;
+    if (op == ">")  return Predicate::Op::Greater;
+    if (op == ">=") return Predicate::Op::GreaterEqual;
+    if (op == "~")  return Predicate::Op::Prefix;
+    return std::nullopt;
+}
+
+template <typename T>
+bool Compare(Predicate::Op op, const T& lhs, const T& rhs)
+{
+    switch (op) {
+        case Predicate::Op::Equal:        return lhs == rhs;
+        case Predicate::Op::NotEqual:     return lhs != rhs;
+        case Predicate::Op::Less:         return lhs < rhs;
+        case Predicate::Op::LessEqual:    return lhs <= rhs;
+        case Predicate::Op::Greater:      return lhs > rhs;
+        case Predicate::Op::GreaterEqual: return lhs >= rhs;
+        case Predicate::Op::Prefix:       break;
+    }
+    return false;
+}
+
+// Fills mask[i] for keys[0, count). One branch-free loop per op so the
+// compiler can vectorize it. NaN keys fail every comparison except !=.
+void MatchNumericBatch(Predicate::Op op, double rhs, const double* keys, uint8_t* mask, size_t count)
+{
+    switch (op) {
+        case Predicate::Op::Equal:        for (size_t i = 0; i < count; ++i) mask[i] = keys[i] == rhs; break;
+        case Predicate::Op::NotEqual:     for (size_t i = 0; i < count; ++i) mask[i] = !(keys[i] == rhs); break;
+        case Predicate::Op::Less:         for (size_t i = 0; i < count; ++i) mask[i] = keys[i] < rhs; break;
+        case Predicate::Op::LessEqual:    for (size_t i = 0; i < count; ++i) mask[i] = keys[i] <= rhs; break;
+        case Predicate::Op::Greater:      for (size_t i = 0; i < count; ++i) mask[i] = keys[i] > rhs; break;
+        case Predicate::Op::GreaterEqual: for (size_t i = 0; i < count; ++i) mask[i] = keys[i] >= rhs; break;
+        case Predicate::Op::Prefix:       for (size_t i = 0; i < count; ++i) mask[i] = 0; break;
+    }
+}
+
+void Accumulate(Group& group, double value)
+{
+    if (std::isnan(value)) return;
+    if (group.numericCount == 0) {
+        group.min = group.max = value;
+    } else {
+        group.min = std::min(group.min, value);
+        group.max = std::max(group.max, value);
+    }
+    group.sum += value;
+    ++group.numericCount;
+}
+
+void Merge(Group& into, Group&& from)
+{
+    if (from.numericCount > 0) {
+        if (into.numericCount == 0) {
+            into.min = from.min;
+            into.max = from.max;
+        } else {
+            into.min = std::min(into.min, from.min);
+            into.max = std::max(into.max, from.max);
+        }
+        into.sum += from.sum;
+        into.numericCount += from.numericCount;
+    }
+    into.members.insert(into.members.end(), from.members.begin(), from.members.end());
+}
+
+std::string FormatNumber(double value)
+{
+    char buffer[64];
+    auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof buffer, value);
+    return std::string(buffer, ptr);
+}
+
+}
+
+std::optional<SortSpec> ParseSortSpec(const std::vector<std::string>& args)
+{
+    if (args.empty()) return std::nullopt;
+
+    SortSpec spec;
+    auto column = ParseColumn(args[0]);
+    if (!column) return std::nullopt;
+    spec.column = *column;
+
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "numeric")      spec.key = SortSpec::Key::Numeric;
+        else if (arg == "lexical") spec.key = SortSpec::Key::Lexical;
+        else if (arg == "asc")     spec.descending = false;
+        else if (arg == "desc")    spec.descending = true;
+        else return std::nullopt;
+    }
+    return spec;
+}
+
+void SortIndices(const RowTable& table, ColumnCache& columns, std::vector<size_t>& indices, const SortSpec& spec)
+{
+    ScopedTimer timer(PerfStage::Sort);
+    const size_t n = indices.size();
+    const bool desc = spec.descending;
+
+    if (spec.key == SortSpec::Key::Numeric) {
+        const auto& values = columns.Numeric(table, spec.column).values;
+        std::vector<std::pair<double, size_t>> keyed(n);
+        ParallelFor(n, 1 << 16, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; ++i) {
+                keyed[i] = {values[indices[i]], indices[i]};
+            }
+        });
+        // NaN marks non-numeric fields; they go last in either direction.
+        SortByKey(keyed, indices, [desc](double a, double b) {
+            if (std::isnan(a) || std::isnan(b)) return !std::isnan(a) && std::isnan(b);
+            return desc ? b < a : a < b;
+        });
+        return;
+    }
+
+    std::vector<std::pair<std::string_view, size_t>> keyed(n);
+    ParallelFor(n, 1 << 16, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& row = table[indices[i]];
+            keyed[i] = {spec.column < row.size() ? std::string_view{row[spec.column]} : std::string_view{}, indices[i]};
+        }
+    });
+    SortByKey(keyed, indices, [desc](std::string_view a, std::string_view b) {
+        return desc ? b < a : a < b;
+    });
+}
+
+std::optional<Predicate> ParsePredicate(const std::vector<std::string>& args)
+{
+    if (args.size() < 3) return std::nullopt;
+
+    Predicate predicate;
+    auto column = ParseColumn(args[0]);
+    auto op = ParseOp(args[1]);
+    if (!column || !op) return std::nullopt;
+    predicate.column = *column;
+    predicate.op = *op;
+
+    // The value may contain spaces; the command line arrives split on them.
+    for (size_t i = 2; i < args.size(); ++i) {
+        if (i > 2) predicate.value += ' ';
+        predicate.value += args[i];
+    }
+
+    predicate.numeric = predicate.op != Predicate::Op::Prefix && ParseNumber(predicate.value, predicate.number);
+    return predicate;
+}
+
+std::vector<size_t> FilterIndices(const RowTable& table, ColumnCache& columns, std::span<const size_t> indices, const Predicate& predicate)
+{
+    ScopedTimer timer(PerfStage::Filter);
+    const double* numbers = predicate.numeric ? columns.Numeric(table, predicate.column).values.data() : nullptr;
+    const std::string_view value = predicate.value;
+
+    std::vector<std::vector<size_t>> partial(ChunkCount(indices.size(), 1 << 14));
+    ParallelFor(indices.size(), 1 << 14, [&](size_t begin, size_t end, size_t chunk) {
+        auto& out = partial[chunk];
+        std::array<double, kBatchSize> keys;
+        std::array<uint8_t, kBatchSize> mask;
+
+        for (size_t batch = begin; batch < end; batch += kBatchSize) {
+            const size_t count = std::min(kBatchSize, end - batch);
+            const size_t* rows = indices.data() + batch;
+
+            if (numbers) {
+                for (size_t i = 0; i < count; ++i) keys[i] = numbers[rows[i]];
+                MatchNumericBatch(predicate.op, predicate.number, keys.data(), mask.data(), count);
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    const auto& row = table[rows[i]];
+                    std::string_view field = predicate.column < row.size() ? std::string_view{row[predicate.column]} : std::string_view{};
+                    mask[i] = predicate.op == Predicate::Op::Prefix
+                        ? field.starts_with(value)
+                        : Compare(predicate.op, field, value);
+                }
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                if (mask[i]) out.push_back(rows[i]);
+            }
+        }
+    });
+
+    size_t total = 0;
+    for (const auto& part : partial) total += part.size();
+
+    std::vector<size_t> result;
+    result.reserve(total);
+    for (const auto& part : partial) {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    return result;
+}
+
+std::optional<GroupSpec> ParseGroupSpec(const std::vector<std::string>& args)
+{
+    if (args.empty() || args.size() > 2) return std::nullopt;
+
+    GroupSpec spec;
+    auto column = ParseColumn(args[0]);
+    if (!column) return std::nullopt;
+    spec.column = *column;
+
+    if (args.size() == 2) {
+        spec.valueColumn = ParseColumn(args[1]);
+        if (!spec.valueColumn) return std::nullopt;
+    }
+    return spec;
+}
+
+std::vector<Group> GroupIndices(const RowTable& table, ColumnCache& columns, std::span<const size_t> indices, const GroupSpec& spec)
+{
+    const double* values = spec.valueColumn ? columns.Numeric(table, *spec.valueColumn).values.data() : nullptr;
+
+    // Partial tables key on views into the table's fields; keys are copied only once, at the end.
+    struct Partial {
+        std::unordered_map<std::string_view, size_t> lookup;
+        std::vector<std::pair<std::string_view, Group>> groups;
+    };
+
+    std::vector<Partial> partials(ChunkCount(indices.size(), 1 << 14));
+    ParallelFor(indices.size(), 1 << 14, [&](size_t begin, size_t end, size_t chunk) {
+        Partial& partial = partials[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            const size_t row = indices[i];
+            const auto& fields = table[row];
+            std::string_view key = spec.column < fields.size() ? std::string_view{fields[spec.column]} : std::string_view{};
+
+            auto [it, inserted] = partial.lookup.try_emplace(key, partial.groups.size());
+            if (inserted) partial.groups.emplace_back(key, Group{});
+            Group& group = partial.groups[it->second].second;
+            group.members.push_back(row);
+            if (values) Accumulate(group, values[row]);
+        }
+    });
+
+    Partial merged;
+    for (Partial& partial : partials) {
+        for (auto& [key, group] : partial.groups) {
+            auto [it, inserted] = merged.lookup.try_emplace(key, merged.groups.size());
+            if (inserted) {
+                merged.groups.emplace_back(key, std::move(group));
+            } else {
+                Merge(merged.groups[it->second].second, std::move(group));
+            }
+        }
+    }
+
+    std::vector<Group> result;
+    result.reserve(merged.groups.size());
+    for (auto& [key, group] : merged.groups) {
+        group.key = std::string{key};
+        result.push_back(std::move(group));
+    }
+    std::ranges::sort(result, [](const Group& a, const Group& b) {
+        if (a.members.size() != b.members.size()) return a.members.size() > b.members.size();
+        return a.key < b.key;
+    });
+    return result;
+}
+
+RowTable GroupsToRowTable(const std::vector<Group>& groups, bool withValues)
+{
+    RowTable table;
+    table.data.reserve(groups.size());
+    for (const Group& group : groups) {
+        RowTable::row_t row = {group.key, std::to_string(group.members.size())};
+        if (withValues) {
+            bool any = group.numericCount > 0;
+            row.push_back(FormatNumber(group.sum));
+            row.push_back(any ? FormatNumber(group.min) : "");
+            row.push_back(any ? FormatNumber(group.max) : "");
+        }
+        table.data.push_back(std::move(row));
+    }
+    table.Touch();
+    return table;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "RowTable.hpp"
+#include "columns.hpp"
+
+// --- sort -----------------------------------------------------------------------
+
+struct SortSpec {
+    enum class Key { Lexical, Numeric };
+
+    size_t column = 0;
+    Key key = Key::Lexical;
+    bool descending = false;
+};
+
+// Parses `<col> [numeric|lexical] [asc|desc]`.
+std::optional<SortSpec> ParseSortSpec(const std::vector<std::string>& args);
+
+// Reorders `indices` (row ids into table) by the spec's column; RowTable storage is
+// untouched. Ties keep ascending row order and non-numeric fields sort last.
+void SortIndices(const RowTable& table, ColumnCache& columns, std::vector<size_t>& indices, const SortSpec& spec);
+
+// --- where ----------------------------------------------------------------------
+
+struct Predicate {
+    enum class Op { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual, Prefix };
+
+    size_t column = 0;
+    Op op = Op::Equal;
+    std::string value;
+    bool numeric = false;   // value parsed as a number; compare against the numeric column
+    double number = 0;
+};
+
+// Parses `<col> <op> <value>` with op one of == != < <= > >= ~ (prefix match).
+// Comparisons are numeric when value is a number (non-numeric fields then only
+// match !=), lexical otherwise. `~` is always a string prefix match.
+std::optional<Predicate> ParsePredicate(const std::vector<std::string>& args);
+
+// Rows of `indices` that satisfy the predicate, in their original order.
+// Evaluated in fixed-size batches over typed column data, split across threads.
+std::vector<size_t> FilterIndices(const RowTable& table, ColumnCache& columns, std::span<const size_t> indices, const Predicate& predicate);
+
+// --- group ----------------------------------------------------------------------
+
+struct GroupSpec {
+    size_t column = 0;
+    std::optional<size_t> valueColumn;   // Aggregate sum/min/max of this numeric column
+};
+
+// Parses `<col> [<value col>]`.
+std::optional<GroupSpec> ParseGroupSpec(const std::vector<std::string>& args);
+
+struct Group {
+    std::string key;
+    std::vector<size_t> members;   // Row ids, in the order of the grouped indices
+    size_t numericCount = 0;       // Members whose value column is numeric
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+};
+
+// Hash-aggregates `indices` by the spec's column. Each thread builds a partial
+// table over its chunk; partials are merged in chunk order so members keep
+// input order. Groups are sorted by member count, largest first, then by key.
+std::vector<Group> GroupIndices(const RowTable& table, ColumnCache& columns, std::span<const size_t> indices, const GroupSpec& spec);
+
+// One row per group: key | count, plus | sum | min | max with a value column.
+RowTable GroupsToRowTable(const std::vector<Group>& groups, bool withValues);
@@ -1,5 +1,6 @@
 #include "registries.hpp"
 #include "app.hpp"
+#include "perf.hpp"
 
 #include <filesystem>
 #include <numeric>
@@ -10,6 +11,7 @@ bool CommandRegistry::Execute(const std::string& line) const {
     iss >> cmd;
     if(auto it = commands_.find(cmd); it != commands_.end())
     {
+        TraceSpan span("command", cmd);
         auto args = line
             | std::views::split(' ')
             | std::views::drop(1)
@@ -84,29 +86,33 @@ void CommandRegistry::RegisterDefaultCommands()
         if (!maybeIdx) return false;
         size_t origIdx = *maybeIdx;
 
-        // Remove from selections
-        m_app.controls.selections.erase(origIdx);
+        // Remove from selections, shifting indices greater than deleted down by one
+        m_app.controls.selections.EraseAndShift(origIdx);
 
-        // Adjust selections: decrement indices greater than deleted
-        std::set<size_t> adjusted;
-        for (size_t idx : m_app.controls.selections) {
-            if (idx > origIdx) {
-                adjusted.insert(idx - 1);
-            } else {
-                adjusted.insert(idx);
+        // Remove from base and filtered views and adjust remaining indices
+        for (auto* indices : {&m_app.controls.baseIndices, &m_app.controls.filteredIndices}) {
+            std::erase(*indices, origIdx);
+            for (size_t& idx : *indices) {
+                if (idx > origIdx) idx--;
             }
         }
-        m_app.controls.selections = std::move(adjusted);
-
-        // Remove from filteredIndices and adjust remaining indices
         auto& fi = m_app.controls.filteredIndices;
-        fi.erase(std::remove(fi.begin(), fi.end(), origIdx), fi.end());
-        for (size_t& idx : fi) {
-            if (idx > origIdx) idx--;
+
+        // In a group view the row is a group; drop its member list with it
+        auto& members = m_app.groupView.members;
+        if (m_app.groupView.isActive && origIdx < members.size()) {
+            members.erase(members.begin() + origIdx);
         }
 
-        // Delete from original data
-        m_app.state.lines.Erase(origIdx);
+        // Delete from original data, keeping the search labels aligned with it
+        auto& lines = m_app.state.lines;
+        auto& labels = m_app.cache.menuEntries;
+        const bool labelsCurrent = m_app.cache.menuEntriesGeneration == lines.generation;
+        lines.Erase(origIdx);
+        if (origIdx < labels.size()) {
+            labels.erase(labels.begin() + origIdx);
+        }
+        if (labelsCurrent) m_app.cache.menuEntriesGeneration = lines.generation;
         m_app.UpdateFilteredView();
 
         // Adjust selected if it's now out of bounds
@@ -167,22 +173,27 @@ void CommandRegistry::RegisterDefaultCommands()
     });
 
     Register("select", [this](const std::vector<std::string>& args){
-        if (m_app.controls.selections.empty()) {
+        if (m_app.groupView.isActive) {
+            return m_app.DrillDownGroup(m_app.controls.selected);
+        }
+
+        if (m_app.controls.selections.None()) {
             // No multi-selection: use current focused item
             auto maybeIdx = m_app.GetOriginalIndex(m_app.controls.selected);
             if (!maybeIdx) return false;
-            m_app.state.output = m_app.state.lines.Substitute(m_app.controls.viewTemplate, *maybeIdx);
+            m_app.state.output = m_app.state.lines.Substitute(m_app.CompiledViewTemplate(), *maybeIdx);
         } else {
             // Multi-selection: output in original data order
+            const CompiledTemplate& viewTemplate = m_app.CompiledViewTemplate();
+            const auto& lines = m_app.state.lines;
             std::string output;
-            for (size_t origIdx = 0; origIdx < m_app.state.lines.data.size(); ++origIdx) {
-                if (m_app.controls.selections.contains(origIdx)) {
-                    if (!output.empty()) {
-                        output += '\n';
-                    }
-                    output += m_app.state.lines.Substitute(m_app.controls.viewTemplate, origIdx);
+            m_app.controls.selections.ForEachSet([&](size_t origIdx) {
+                if (origIdx >= lines.data.size()) return;
+                if (!output.empty()) {
+                    output += '\n';
                 }
-            }
+                viewTemplate.RenderInto(output, lines[origIdx]);
+            });
             m_app.state.output = output;
         }
         m_app.screen.ExitLoopClosure()();
@@ -209,6 +220,59 @@ void CommandRegistry::RegisterDefaultCommands()
         return true;
     });
 
+    Register("sort", [this](const std::vector<std::string>& args) {
+        auto spec = ParseSortSpec(args);
+        if (!spec) return false;
+        m_app.SortView(*spec);
+        return true;
+    });
+
+    Register("where", [this](const std::vector<std::string>& args) {
+        if (args.empty()) {
+            m_app.ClearViewFilters();
+            return true;
+        }
+
+        auto predicate = ParsePredicate(args);
+        if (!predicate) return false;
+        m_app.FilterView(*predicate);
+        return true;
+    });
+
+    Register("group", [this](const std::vector<std::string>& args) {
+        auto spec = ParseGroupSpec(args);
+        if (!spec) return false;
+        m_app.ShowGroups(*spec);
+        return true;
+    });
+
+    Register("ungroup", [this](const std::vector<std::string>& args) {
+        return m_app.CloseGroups();
+    });
+
+    Register("perf", [this](const std::vector<std::string>& args) {
+        if (args.empty()) {
+            m_app.SetPerfHud(!m_app.state.perfHud);
+        } else if (args[0] == "on") {
+            m_app.SetPerfHud(true);
+        } else if (args[0] == "off") {
+            m_app.SetPerfHud(false);
+        } else if (args[0] == "reset") {
+            Perf::Reset();
+            m_app.PreviewWorkers().ResetStats();
+        } else {
+            return false;
+        }
+        return true;
+    });
+
+    Register("mem", [this](const std::vector<std::string>& args) {
+        m_app.controls.display.string = m_app.MemoryReport();
+        m_app.controls.display.cursorPosition = 0;
+        m_app.controls.display.isActive = true;
+        return true;
+    });
+
     Register("preview", [this](const std::vector<std::string>& args) {
         m_app.TogglePreview();
         return true;
@@ -216,6 +280,30 @@ void CommandRegistry::RegisterDefaultCommands()
 
     Register("preview-refresh", [this](const std::vector<std::string>& args) {
         m_app.scope.ClearCache();
+        m_app.UpdatePreview(true);
+        return true;
+    });
+
+    // preview-cmd <template>: render previews with a command; no args restores the built-in previews
+    Register("preview-cmd", [this](const std::vector<std::string>& args) {
+        std::string previewCommand;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (i > 0) previewCommand += " ";
+            previewCommand += args[i];
+        }
+        m_app.controls.previewCommand = previewCommand;
+        m_app.UpdatePreview();
+        return true;
+    });
+
+    // preview-helper <command>: send preview commands to one long-lived helper; no args stops it
+    Register("preview-helper", [this](const std::vector<std::string>& args) {
+        std::string helper;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (i > 0) helper += " ";
+            helper += args[i];
+        }
+        m_app.scope.SetPreviewHelper(helper);
         m_app.UpdatePreview();
         return true;
     });
@@ -248,7 +336,7 @@ void KeybindRegistry::RegisterDefaultKeybinds()
     Register(
         ftxui::Event::Character('/'),
         Command([this](const std::vector<std::string>&){
-            m_app.cache.menuEntries = m_app.state.lines.GetMenuEntries(m_app.controls.viewTemplate);
+            m_app.BuildSearchLabels();
             m_app.controls.searchDialog.placeholder = "Type to fuzzy search";
             m_app.FocusSearch();
             return true;
@@ -1,25 +1,53 @@
 #include "scope.hpp"
 #include "utils.hpp"
+#include "perf.hpp"
+#include "dirlist.hpp"
+#include "process.hpp"
 
-#include <regex>
-#include <filesystem>
 #include <sstream>
 #include <algorithm>
+#include <charconv>
 
-namespace fs = std::filesystem;
+// Bump when rendering changes, so stale previews on disk are never served.
+static constexpr int kRenderVersion = 2;
 
-// Regex patterns for content detection
-static const std::regex vimgrep_regex(R"(^(.+?):(\d+):(\d+):.*$)");
-static const std::regex grep_regex(R"(^(.+?):(\d+):.*$)");
+// URL fetchers get this long before their whole pipeline is killed.
+static constexpr std::chrono::seconds kFetchTimeout{5};
 
-std::string Scope::Process(const std::string& input)
+std::string Scope::Process(const std::string& input, std::stop_token stop, bool refresh,
+                           const PreviewSink& onOutput)
 {
+    ScopedTimer timer(PerfStage::Preview);
+
     // Check cache first
-    if (auto* cached = CacheLookup(input)) {
-        return *cached;
+    if (refresh) {
+        m_stats.Clear();
+    } else {
+        if (auto cached = m_cache.Lookup(input)) {
+            return *cached;
+        }
     }
 
     auto parsed = Parse(input);
+    std::string diskKey = m_disk ? DiskKey(parsed) : std::string();
+    if (!refresh && !diskKey.empty()) {
+        if (auto stored = m_disk->Lookup(diskKey)) {
+            m_cache.Insert(input, *stored);
+            return std::move(*stored);
+        }
+    }
+
+    // A sink that declines more output leaves the render incomplete
+    bool truncated = false;
+    PreviewSink sink;
+    if (onOutput) {
+        sink = [&onOutput, &truncated](std::string_view chunk) {
+            if (onOutput(chunk)) return true;
+            truncated = true;
+            return false;
+        };
+    }
+
     std::string result;
 
     switch (parsed.type) {
@@ -28,13 +56,13 @@ std::string Scope::Process(const std::string& input)
             result = RenderFileAtLine(parsed.filepath, parsed.line);
             break;
         case ContentType::URL:
-            result = RenderURL(parsed.url);
+            result = RenderURL(parsed.url, stop, sink);
             break;
         case ContentType::FilePath:
             result = RenderFile(parsed.filepath);
             break;
         case ContentType::Directory:
-            result = RenderDirectory(parsed.filepath);
+            result = RenderDirectory(parsed.filepath, stop);
             break;
         case ContentType::Unknown:
         default:
@@ -42,10 +70,168 @@ std::string Scope::Process(const std::string& input)
             break;
     }
 
-    CacheInsert(input, result);
+    // A stopped render may be cut short; never cache it
+    if (stop.stop_requested()) return {};
+
+    // Shown, but not cached: the next render of this row reads it all again
+    if (truncated) return result;
+
+    m_cache.Insert(input, result);
+    if (!diskKey.empty()) {
+        m_disk->Insert(diskKey, result);
+    }
+    return result;
+}
+
+std::string Scope::ProcessCommand(const std::string& command, std::stop_token stop, bool refresh,
+                                  const PreviewSink& onOutput)
+{
+    ScopedTimer timer(PerfStage::Preview);
+
+    const std::string key = CommandKey(command);
+    if (!refresh) {
+        if (auto cached = m_cache.Lookup(key)) {
+            return *cached;
+        }
+    }
+
+    std::string result;
+    bool truncated = false;
+    if (auto helper = PreviewHelper()) {
+        auto response = helper->Request(command, stop, onOutput, &truncated);
+        if (!response) {
+            // Not cached, so the next look at this row tries again
+            return "[" + response.error() + "]";
+        }
+        result = std::move(*response);
+    } else {
+        // Errors would draw over the UI
+        auto run = RunShell(command, {.discardStderr = true, .stop = stop, .onOutput = onOutput});
+        if (!run) {
+            return "[Failed to run preview command: " + command + "]";
+        }
+        result = std::move(run->output);
+        truncated = run->truncated;
+    }
+
+    if (stop.stop_requested()) return {};
+
+    // Cut short by onOutput: shown, but the next render reads it all again
+    if (truncated) return result;
+
+    m_cache.Insert(key, result);
     return result;
 }
 
+void Scope::SetPreviewHelper(const std::string& command)
+{
+    auto helper = command.empty() ? nullptr : std::make_shared<Coprocess>(command);
+    std::lock_guard lock(m_helperMutex);
+    m_helper = std::move(helper);
+}
+
+std::shared_ptr<Coprocess> Scope::PreviewHelper() const
+{
+    std::lock_guard lock(m_helperMutex);
+    return m_helper;
+}
+
+std::string Scope::CommandKey(const std::string& command) const
+{
+    // A leading NUL keeps it apart from row text; the helper is part of the
+    // key because it decides what the command means.
+    auto helper = PreviewHelper();
+    std::string key(1, '\0');
+    if (helper) key += helper->Command();
+    key += '\0';
+    key += command;
+    return key;
+}
+
+std::expected<void, std::string> Scope::OpenDiskCache(const std::string& dir)
+{
+    auto disk = DiskCache::Open(dir);
+    if (!disk) return std::unexpected(disk.error());
+    m_disk = std::move(*disk);
+    return {};
+}
+
+std::string Scope::DiskKey(const ParsedContent& parsed) const
+{
+    // Not directories: a listing shows its children's sizes and times, which
+    // change without touching the directory's own mtime.
+    switch (parsed.type) {
+        case ContentType::FilePath:
+        case ContentType::GrepOutput:
+        case ContentType::VimgrepOutput:
+            break;
+        default:
+            return {};
+    }
+
+    StatCache::Info info = m_stats.Get(parsed.filepath);
+    if (!info.exists) return {};
+
+    // Everything the rendered text depends on; the path goes last so no
+    // separator inside it can make two keys collide.
+    return std::to_string(kRenderVersion) + '\t' + std::to_string(static_cast<int>(parsed.type))
+         + '\t' + std::to_string(parsed.line) + '\t' + std::to_string(info.size)
+         + '\t' + std::to_string(info.mtimeNs) + '\t' + parsed.filepath;
+}
+
+namespace {
+
+size_t DigitRun(std::string_view text, size_t pos)
+{
+    size_t end = pos;
+    while (end < text.size() && text[end] >= '0' && text[end] <= '9') ++end;
+    return end - pos;
+}
+
+// Position of the colon ending a non-empty run of digits at pos, or npos
+size_t NumberField(std::string_view text, size_t pos)
+{
+    size_t end = pos + DigitRun(text, pos);
+    return end > pos && end < text.size() && text[end] == ':' ? end : std::string_view::npos;
+}
+
+std::optional<int> ToInt(std::string_view digits)
+{
+    int value = 0;
+    auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (ec != std::errc() || ptr != digits.data() + digits.size()) return std::nullopt;
+    return value;
+}
+
+}
+
+LineReferences FindLineReferences(std::string_view text)
+{
+    LineReferences refs;
+    if (text.find_first_of("\r\n") != std::string_view::npos) return refs;
+
+    bool grepFound = false;
+    for (size_t colon = text.find(':', 1); colon != std::string_view::npos; colon = text.find(':', colon + 1)) {
+        size_t lineEnd = NumberField(text, colon + 1);
+        if (lineEnd == std::string_view::npos) continue;
+
+        std::string_view path = text.substr(0, colon);
+        auto line = ToInt(text.substr(colon + 1, lineEnd - colon - 1));
+        if (!grepFound) {
+            grepFound = true;
+            if (line) refs.grep = LineReference{path, *line, 0};
+        }
+
+        size_t colEnd = NumberField(text, lineEnd + 1);
+        if (colEnd == std::string_view::npos) continue;
+
+        auto col = ToInt(text.substr(lineEnd + 1, colEnd - lineEnd - 1));
+        if (line && col) refs.vimgrep = LineReference{path, *line, *col};
+        break;
+    }
+    return refs;
+}
+
 ParsedContent Scope::Parse(const std::string& input) const
 {
     ParsedContent result;
@@ -58,56 +244,48 @@ ParsedContent Scope::Parse(const std::string& input) const
     }
 
     // 1. Try vimgrep pattern first (most specific: file:line:col:text)
-    std::smatch match;
-    if (std::regex_match(trimmed, match, vimgrep_regex)) {
-        std::string filepath = match[1].str();
-        if (fs::exists(filepath) && fs::is_regular_file(filepath)) {
-            result.type = ContentType::VimgrepOutput;
-            result.filepath = filepath;
-            result.line = std::stoi(match[2].str());
-            result.col = std::stoi(match[3].str());
-            return result;
-        }
+    LineReferences refs = FindLineReferences(trimmed);
+    if (refs.vimgrep && m_stats.Get(refs.vimgrep->path).IsFile()) {
+        result.type = ContentType::VimgrepOutput;
+        result.filepath = refs.vimgrep->path;
+        result.line = refs.vimgrep->line;
+        result.col = refs.vimgrep->col;
+        return result;
     }
 
     // 2. Try grep pattern (file:line:text)
-    if (std::regex_match(trimmed, match, grep_regex)) {
-        std::string filepath = match[1].str();
-        if (fs::exists(filepath) && fs::is_regular_file(filepath)) {
-            result.type = ContentType::GrepOutput;
-            result.filepath = filepath;
-            result.line = std::stoi(match[2].str());
-            return result;
-        }
+    if (refs.grep && m_stats.Get(refs.grep->path).IsFile()) {
+        result.type = ContentType::GrepOutput;
+        result.filepath = refs.grep->path;
+        result.line = refs.grep->line;
+        return result;
     }
 
     // 3. Try URL extraction
-    std::string url = ExtractFirstURL(trimmed);
-    if (!url.empty()) {
+    if (std::string_view url = FindURL(trimmed); !url.empty()) {
         result.type = ContentType::URL;
         result.url = url;
         return result;
     }
 
     // 4. Try file path or directory
-    if (fs::exists(trimmed)) {
-        if (fs::is_regular_file(trimmed)) {
-            result.type = ContentType::FilePath;
-            result.filepath = trimmed;
-            return result;
-        }
-        if (fs::is_directory(trimmed)) {
-            result.type = ContentType::Directory;
-            result.filepath = trimmed;
-            return result;
-        }
+    StatCache::Info info = m_stats.Get(trimmed);
+    if (info.IsFile()) {
+        result.type = ContentType::FilePath;
+        result.filepath = std::move(trimmed);
+        return result;
+    }
+    if (info.IsDirectory()) {
+        result.type = ContentType::Directory;
+        result.filepath = std::move(trimmed);
+        return result;
     }
 
     result.type = ContentType::Unknown;
     return result;
 }
 
-std::string Scope::RenderURL(const std::string& url) const
+std::string Scope::RenderURL(const std::string& url, std::stop_token stop, const PreviewSink& onOutput) const
 {
     // Escape single quotes for shell safety
     std::string escaped;
@@ -119,41 +297,18 @@ std::string Scope::RenderURL(const std::string& url) const
         }
     }
 
-    // Use timeout to prevent hangs (5 second timeout)
-    const std::string timeout = "timeout 5 ";
-
-    // Try w3m first, fall back to lynx, then curl
-    std::string cmd = timeout + "w3m -dump '" + escaped + "' 2>/dev/null | head -n 50";
-
-    try {
-        std::string result = ExecAndCapture(cmd);
-        if (!result.empty()) {
-            return result;
-        }
-    } catch (...) {
-        // w3m failed, try fallback
-    }
-
-    // Fallback to lynx
-    cmd = timeout + "lynx -dump -nolist '" + escaped + "' 2>/dev/null | head -n 50";
-    try {
-        std::string result = ExecAndCapture(cmd);
-        if (!result.empty()) {
-            return result;
-        }
-    } catch (...) {
-        // lynx failed, try curl
-    }
-
-    // Last resort: curl with timeout flag
-    cmd = "curl -sL --max-time 5 '" + escaped + "' 2>/dev/null | head -n 50";
-    try {
-        std::string result = ExecAndCapture(cmd);
-        if (!result.empty()) {
-            return result;
+    // Try w3m first, fall back to lynx, then curl. Errors would draw over the UI.
+    const std::string fetchers[] = {
+        "w3m -dump '" + escaped + "' | head -n 50",
+        "lynx -dump -nolist '" + escaped + "' | head -n 50",
+        "curl -sL '" + escaped + "' | head -n 50",
+    };
+    for (const auto& cmd : fetchers) {
+        auto run = RunShell(cmd, {.discardStderr = true, .stop = stop, .timeout = kFetchTimeout, .onOutput = onOutput});
+        if (stop.stop_requested()) return {};
+        if (run && !run->output.empty()) {
+            return std::move(run->output);
         }
-    } catch (...) {
-        // curl also failed
     }
 
     return "[Timeout or failed to fetch URL: " + url + "]";
@@ -161,90 +316,44 @@ std::string Scope::RenderURL(const std::string& url) const
 
 std::string Scope::RenderFile(const std::string& filepath) const
 {
-    // Escape single quotes for shell safety
-    std::string escaped;
-    for (char c : filepath) {
-        if (c == '\'') {
-            escaped += "'\\''";
-        } else {
-            escaped += c;
-        }
-    }
-
-    // Check if it's a binary file
-    std::string fileCmd = "file -b '" + escaped + "' 2>/dev/null";
-    try {
-        std::string fileType = ExecAndCapture(fileCmd);
-        if (fileType.find("text") == std::string::npos &&
-            fileType.find("ASCII") == std::string::npos &&
-            fileType.find("UTF") == std::string::npos &&
-            fileType.find("empty") == std::string::npos) {
-            return "[Binary file: " + filepath + "]\n" + fileType;
-        }
-    } catch (...) {
-        // Ignore file command failure, try to read anyway
-    }
-
-    std::string cmd = "head -n 50 '" + escaped + "' 2>/dev/null";
-    try {
-        return ExecAndCapture(cmd);
-    } catch (...) {
+    auto excerpt = ReadFileLines(filepath, 1, 50);
+    if (!excerpt) {
         return "[Failed to read file: " + filepath + "]";
     }
+    if (excerpt->binary) {
+        return "[Binary file: " + filepath + "]";
+    }
+    return std::move(excerpt->text);
 }
 
-std::string Scope::RenderDirectory(const std::string& dirpath) const
+std::string Scope::RenderDirectory(const std::string& dirpath, std::stop_token stop) const
 {
-    // Escape single quotes for shell safety
-    std::string escaped;
-    for (char c : dirpath) {
-        if (c == '\'') {
-            escaped += "'\\''";
-        } else {
-            escaped += c;
-        }
-    }
-
-    std::string cmd = "ls -la '" + escaped + "' 2>/dev/null | head -n 50";
-    try {
-        std::ostringstream header;
-        header << "=== " << dirpath << "/ ===\n\n";
-        return header.str() + ExecAndCapture(cmd);
-    } catch (...) {
+    auto listing = ListDirectory(dirpath, 50, kDefaultCountCap, stop);
+    if (!listing) {
         return "[Failed to list directory: " + dirpath + "]";
     }
+    return "=== " + dirpath + "/ ===\n\n" + FormatListing(*listing);
 }
 
-std::string Scope::RenderFileAtLine(const std::string& filepath, int line) const
+std::string Scope::RenderFileAtLine(const std::string& filepath, int line)
 {
-    // Escape single quotes for shell safety
-    std::string escaped;
-    for (char c : filepath) {
-        if (c == '\'') {
-            escaped += "'\\''";
-        } else {
-            escaped += c;
-        }
-    }
-
     int contextLines = 10;
     int startLine = std::max(1, line - contextLines);
     int endLine = line + contextLines;
 
-    std::string cmd = "sed -n '" + std::to_string(startLine) + "," +
-                      std::to_string(endLine) + "p' '" + escaped + "' 2>/dev/null";
-
-    try {
-        std::string content = ExecAndCapture(cmd);
-
-        // Add a header showing file:line
-        std::ostringstream header;
-        header << "=== " << filepath << ":" << line << " ===\n\n";
-
-        return header.str() + content;
-    } catch (...) {
+    auto excerpt = ReadFileLines(filepath, startLine, endLine - startLine + 1, &m_lineIndexes);
+    if (!excerpt) {
         return "[Failed to read file: " + filepath + "]";
     }
+    if (excerpt->binary) {
+        return "[Binary file: " + filepath + "]";
+    }
+
+    // Add a header showing file:line
+    std::ostringstream header;
+    header << "=== " << filepath << ":" << line << " ===\n\n";
+
+    return header.str() + excerpt->text;
 }
 
 std::string Scope::RenderUnknown(const std::string& content) const
@@ -254,39 +363,7 @@ std::string Scope::RenderUnknown(const std::string& content) const
 
 void Scope::ClearCache()
 {
-    m_cacheList.clear();
-    m_cacheMap.clear();
-}
-
-void Scope::CacheInsert(const std::string& key, const std::string& value)
-{
-    // If key exists, move to front and update value
-    auto it = m_cacheMap.find(key);
-    if (it != m_cacheMap.end()) {
-        m_cacheList.erase(it->second);
-        m_cacheMap.erase(it);
-    }
-
-    // Evict oldest if at capacity
-    if (m_cacheList.size() >= MAX_CACHE_SIZE) {
-        auto& oldest = m_cacheList.back();
-        m_cacheMap.erase(oldest.first);
-        m_cacheList.pop_back();
-    }
-
-    // Insert at front
-    m_cacheList.emplace_front(key, value);
-    m_cacheMap[key] = m_cacheList.begin();
-}
-
-std::string* Scope::CacheLookup(const std::string& key)
-{
-    auto it = m_cacheMap.find(key);
-    if (it == m_cacheMap.end()) {
-        return nullptr;
-    }
-
-    // Move to front (LRU)
-    m_cacheList.splice(m_cacheList.begin(), m_cacheList, it->second);
-    return &it->second->second;
+    m_cache.Clear();
+    m_lineIndexes.Clear();
+    m_stats.Clear();
 }
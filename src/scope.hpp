@@ -1,10 +1,19 @@
 #pragma once
 
+#include "coprocess.hpp"
+#include "disk_cache.hpp"
+#include "fileview.hpp"
+#include "preview_cache.hpp"
+#include "stat_cache.hpp"
+
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
-#include <unordered_map>
-#include <list>
-#include <utility>
+#include <stop_token>
 
 enum class ContentType {
     Unknown,
@@ -24,32 +33,98 @@ struct ParsedContent {
     std::string rawContent;
 };
 
+// The `file:line` part of a grep or vimgrep output line
+struct LineReference {
+    std::string_view path;
+    int line = 0;
+    int col = 0;
+};
+
+struct LineReferences {
+    std::optional<LineReference> vimgrep;   // file:line:col:text
+    std::optional<LineReference> grep;      // file:line:text
+};
+
+// Finds both forms in one pass. Each is taken at the first colon after a
+// non-empty path that is followed by the form's digits and colons, exactly
+// as a lazy `^(.+?):(\d+):` match would; a number too large for an int drops
+// its form. Text with a line break matches neither.
+LineReferences FindLineReferences(std::string_view text);
+
+// Receives a preview's text while it is being rendered; returning false stops
+// the render early, keeping what was produced so far.
+using PreviewSink = std::function<bool(std::string_view chunk)>;
+
 class Scope {
 public:
     Scope() = default;
 
-    // Main entry point: process input and return preview content
-    std::string Process(const std::string& input);
+    // Main entry point: process input and return preview content. Safe to call
+    // from several threads. Once `stop` is requested, helper processes are
+    // killed and "" is returned without caching anything. `refresh` skips the
+    // caches and replaces what they hold for input. Previews rendered by
+    // external commands are also passed to onOutput as their output arrives;
+    // if it declines more, the output so far is returned but not cached.
+    std::string Process(const std::string& input, std::stop_token stop = {}, bool refresh = false,
+                        const PreviewSink& onOutput = {});
 
-    // Detect content type from input string
+    // The cached preview for input, or null; never renders.
+    PreviewCache::Value Cached(const std::string& input) { return m_cache.Lookup(input); }
+
+    // Preview produced by a user command, e.g. a row's --preview-cmd with its
+    // fields substituted, instead of by content type. The command runs through
+    // the shell, or is sent as a request to the preview helper if one is set.
+    // Same stop, refresh and streaming behaviour as Process.
+    std::string ProcessCommand(const std::string& command, std::stop_token stop = {}, bool refresh = false,
+                               const PreviewSink& onOutput = {});
+    PreviewCache::Value CachedCommand(const std::string& command) { return m_cache.Lookup(CommandKey(command)); }
+
+    // Long-lived co-process answering preview commands (see Coprocess), or
+    // "" to run each command on its own. The helper starts on first use.
+    void SetPreviewHelper(const std::string& command);
+    std::shared_ptr<Coprocess> PreviewHelper() const;
+
+    // Detect content type from input string. Each path is stat'ed at most
+    // once per StatCache TTL.
     ParsedContent Parse(const std::string& input) const;
 
-    // Clear the preview cache
+    // Clear the preview cache and forget cached file status
     void ClearCache();
 
+    // Bytes of rendered previews kept in memory (default 64 MiB)
+    void SetCacheBudget(size_t bytes) { m_cache.SetBudget(bytes); }
+
+    // Entries in the preview cache and the bytes they hold
+    size_t CacheEntries() const { return m_cache.Entries(); }
+    size_t CacheBytes() const { return m_cache.Bytes(); }
+
+    // Also keep previews of files and grep matches in dir between sessions,
+    // keyed by path, size, mtime and render parameters. Call before rendering.
+    std::expected<void, std::string> OpenDiskCache(const std::string& dir);
+    const DiskCache* DiskStore() const { return m_disk.get(); }
+
+    // Line indexes of files previewed at a line
+    const LineIndexCache& LineIndexes() const { return m_lineIndexes; }
+
 private:
     // Rendering methods
-    std::string RenderURL(const std::string& url) const;
+    std::string RenderURL(const std::string& url, std::stop_token stop, const PreviewSink& onOutput) const;
     std::string RenderFile(const std::string& filepath) const;
-    std::string RenderDirectory(const std::string& dirpath) const;
-    std::string RenderFileAtLine(const std::string& filepath, int line) const;
+    std::string RenderDirectory(const std::string& dirpath, std::stop_token stop) const;
+    std::string RenderFileAtLine(const std::string& filepath, int line);
     std::string RenderUnknown(const std::string& content) const;
 
-    // LRU Cache (key: input string, value: rendered content)
-    static constexpr size_t MAX_CACHE_SIZE = 50;
-    std::list<std::pair<std::string, std::string>> m_cacheList;
-    std::unordered_map<std::string, decltype(m_cacheList)::iterator> m_cacheMap;
+    // Key for the disk cache, or "" for content that is not worth persisting
+    std::string DiskKey(const ParsedContent& parsed) const;
+
+    // Key for a command's preview in m_cache; never equal to a row's text
+    std::string CommandKey(const std::string& command) const;
 
-    void CacheInsert(const std::string& key, const std::string& value);
-    std::string* CacheLookup(const std::string& key);
+    // Rendered previews keyed by input string
+    PreviewCache m_cache;
+    std::unique_ptr<DiskCache> m_disk;
+    LineIndexCache m_lineIndexes;
+    mutable StatCache m_stats;
+    std::shared_ptr<Coprocess> m_helper;
+    mutable std::mutex m_helperMutex;
 };
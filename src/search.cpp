@@ -0,0 +1,37 @@
+#include "search.hpp"
+#include "utils.hpp"
+#include "perf.hpp"
+
+#include <ranges>
+
+std::vector<size_t> RankMatches(const std::string& query, const std::vector<std::string>& labels, std::span<const size_t> candidates)
+{
+    std::vector<size_t> ranked;
+    RankScratch scratch;
+    RankMatchesInto(query, labels, candidates, ranked, scratch);
+    return ranked;
+}
+
+void RankMatchesInto(const std::string& query, const std::vector<std::string>& labels, std::span<const size_t> candidates,
+                     std::vector<size_t>& ranked, RankScratch& scratch)
+{
+    auto choices = candidates | std::views::transform([&labels](size_t origIdx) -> const std::string& {
+        return labels[origIdx];
+    });
+    {
+        ScopedTimer timer(PerfStage::Extract);
+        extract_into(query, choices, scratch.scored, scratch.lowered);
+    }
+
+    // Sort by score descending
+    std::ranges::sort(scratch.scored, std::ranges::greater{}, [](const auto& p) {
+        return p.second;
+    });
+
+    // Extract indices in sorted order
+    ranked.clear();
+    ranked.reserve(scratch.scored.size());
+    for (const auto& [idx, score] : scratch.scored) {
+        ranked.push_back(candidates[idx]);
+    }
+}
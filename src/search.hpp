@@ -0,0 +1,22 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Buffers RankMatchesInto reuses between calls
+struct RankScratch {
+    std::vector<std::pair<size_t, double>> scored;
+    std::string lowered;
+};
+
+// The ranking pipeline behind fuzzy search: scores the labels of the candidate
+// rows (ids into labels) against query and returns the matches, best first.
+// Shared by the interactive search and headless --filter mode.
+std::vector<size_t> RankMatches(const std::string& query, const std::vector<std::string>& labels, std::span<const size_t> candidates);
+
+// Same as RankMatches, into `ranked`. With ranked and scratch kept across calls,
+// a search allocates nothing once their capacity covers the candidates.
+void RankMatchesInto(const std::string& query, const std::vector<std::string>& labels, std::span<const size_t> candidates,
+                     std::vector<size_t>& ranked, RankScratch& scratch);
@@ -0,0 +1,81 @@
+#include "stat_cache.hpp"
+
+#include <sys/stat.h>
+
+namespace {
+
+StatCache::Info StatPath(const std::string& path)
+{
+    StatCache::Info info;
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return info;
+
+    info.exists = true;
+    info.mode = st.st_mode;
+    info.size = static_cast<uint64_t>(st.st_size);
+    info.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+    return info;
+}
+
+}
+
+bool StatCache::Info::IsFile() const
+{
+    return exists && S_ISREG(mode);
+}
+
+bool StatCache::Info::IsDirectory() const
+{
+    return exists && S_ISDIR(mode);
+}
+
+StatCache::Info StatCache::Get(std::string_view path)
+{
+    const auto now = clock::now();
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_entries.find(path);
+        if (it != m_entries.end() && now - it->second.when < m_ttl) {
+            return it->second.info;
+        }
+    }
+
+    // stat outside the lock; two threads racing on one path both call it,
+    // which is harmless.
+    std::string key(path);
+    Info info = StatPath(key);
+
+    std::lock_guard lock(m_mutex);
+    ++m_calls;
+    if (m_entries.size() >= m_capacity && !m_entries.contains(path)) {
+        m_entries.clear();
+    }
+    m_entries.insert_or_assign(std::move(key), Entry{info, now});
+    return info;
+}
+
+void StatCache::Forget(std::string_view path)
+{
+    std::lock_guard lock(m_mutex);
+    if (auto it = m_entries.find(path); it != m_entries.end()) {
+        m_entries.erase(it);
+    }
+}
+
+void StatCache::Clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_entries.clear();
+}
+
+size_t StatCache::Size() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_entries.size();
+}
+
+size_t StatCache::Calls() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_calls;
+}
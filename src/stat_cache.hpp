@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+// Short-lived cache of stat(2) results, so that every question about a path
+// (does it exist, is it a file or a directory, what are its size and mtime)
+// costs one system call per TTL. Entries older than the TTL are refreshed on
+// the next Get; a full cache is emptied rather than tracked by use. Safe to
+// share between threads.
+class StatCache
+{
+public:
+    struct Info {
+        bool exists = false;    // stat succeeded; the fields below are only set then
+        mode_t mode = 0;
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+
+        bool IsFile() const;
+        bool IsDirectory() const;
+    };
+
+    static constexpr std::chrono::milliseconds kDefaultTtl{1000};
+    static constexpr size_t kDefaultCapacity = 4096;
+
+    explicit StatCache(std::chrono::milliseconds ttl = kDefaultTtl, size_t capacity = kDefaultCapacity)
+        : m_ttl(ttl), m_capacity(capacity) {}
+
+    // stat(path), following symlinks; a failed call reads as !exists.
+    Info Get(std::string_view path);
+
+    // Drops path, or everything, so the next Get calls stat again.
+    void Forget(std::string_view path);
+    void Clear();
+
+    size_t Size() const;
+
+    // Total stat calls made, for tests and stats.
+    size_t Calls() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Entry {
+        Info info;
+        clock::time_point when;
+    };
+
+    struct PathHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view path) const { return std::hash<std::string_view>{}(path); }
+    };
+
+    const clock::duration m_ttl;
+    const size_t m_capacity;
+    size_t m_calls = 0;
+    std::unordered_map<std::string, Entry, PathHash, std::equal_to<>> m_entries;
+    mutable std::mutex m_mutex;
+};
@@ -0,0 +1,114 @@
+#include "template.hpp"
+
+CompiledTemplate::CompiledTemplate(std::string_view source)
+    : m_source(source)
+{
+    auto addLiteral = [this](size_t offset, size_t length) {
+        m_literalSize += length;
+        if (!m_ops.empty() && m_ops.back().kind == OpKind::Literal
+            && m_ops.back().offset + m_ops.back().length == offset) {
+            m_ops.back().length += static_cast<uint32_t>(length);
+            return;
+        }
+        m_ops.push_back({OpKind::Literal, static_cast<uint32_t>(offset), static_cast<uint32_t>(length)});
+    };
+
+    const std::string_view str = m_source;
+    size_t i = 0;
+    while (i < str.size()) {
+        if (str[i] == '{') {
+            size_t close = str.find('}', i + 1);
+            if (close != std::string_view::npos) {
+                std::string_view inner = str.substr(i + 1, close - i - 1);
+                size_t rawLength = close - i + 1;
+
+                if (inner.empty()) {
+                    m_ops.push_back({OpKind::AllFields, static_cast<uint32_t>(i), static_cast<uint32_t>(rawLength)});
+                    ++m_fieldCount;
+                } else {
+                    size_t idx = 0;
+                    bool valid = true;
+                    for (char c : inner) {
+                        if (c >= '0' && c <= '9') {
+                            idx = idx * 10 + (c - '0');
+                        } else {
+                            valid = false;
+                            break;
+                        }
+                    }
+
+                    if (valid) {
+                        m_ops.push_back({OpKind::Field, static_cast<uint32_t>(i), static_cast<uint32_t>(rawLength), idx});
+                        ++m_fieldCount;
+                    } else {
+                        addLiteral(i, rawLength);
+                    }
+                }
+                i = close + 1;
+                continue;
+            }
+        }
+        addLiteral(i, 1);
+        ++i;
+    }
+}
+
+size_t CompiledTemplate::EstimateSize(const row_t& row) const
+{
+    size_t size = m_literalSize;
+    if (m_fieldCount == 0) return size;
+
+    size_t joinedSize = 0;
+    if (!row.empty()) {
+        joinedSize = 3 * (row.size() - 1);
+        for (const auto& field : row) joinedSize += field.size();
+    }
+
+    for (const Op& op : m_ops) {
+        switch (op.kind) {
+            case OpKind::Literal:
+                break;
+            case OpKind::Field:
+                size += op.field < row.size() ? row[op.field].size() : op.length;
+                break;
+            case OpKind::AllFields:
+                size += joinedSize;
+                break;
+        }
+    }
+    return size;
+}
+
+std::string CompiledTemplate::Render(const row_t& row) const
+{
+    std::string result;
+    RenderInto(result, row);
+    return result;
+}
+
+void CompiledTemplate::RenderInto(std::string& out, const row_t& row) const
+{
+    out.reserve(out.size() + EstimateSize(row));
+
+    const std::string_view source = m_source;
+    for (const Op& op : m_ops) {
+        switch (op.kind) {
+            case OpKind::Literal:
+                out.append(source.substr(op.offset, op.length));
+                break;
+            case OpKind::Field:
+                if (op.field < row.size()) {
+                    out += row[op.field];
+                } else {
+                    out.append(source.substr(op.offset, op.length));
+                }
+                break;
+            case OpKind::AllFields:
+                for (size_t j = 0; j < row.size(); ++j) {
+                    if (j > 0) out += " | ";
+                    out += row[j];
+                }
+                break;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A view/command template parsed once into a flat list of ops.
+//
+// `{}` expands to all columns joined with " | ", `{N}` to column N. A `{N}`
+// whose column does not exist in the row, a non-numeric `{...}` and an
+// unclosed `{` are emitted verbatim, matching substitute_template().
+class CompiledTemplate
+{
+public:
+    using row_t = std::vector<std::string>;
+
+    CompiledTemplate() = default;
+    explicit CompiledTemplate(std::string_view source);
+
+    const std::string& Source() const { return m_source; }
+    bool HasPlaceholders() const { return m_fieldCount > 0; }
+
+    // Exact output size for `row`; literal bytes are precomputed at compile time.
+    size_t EstimateSize(const row_t& row) const;
+
+    std::string Render(const row_t& row) const;
+    void RenderInto(std::string& out, const row_t& row) const;
+
+private:
+    enum class OpKind : uint8_t { Literal, Field, AllFields };
+
+    struct Op {
+        OpKind kind;
+        uint32_t offset;   // Literal text, or the raw `{N}` fallback, in m_source
+        uint32_t length;
+        size_t field = 0;
+    };
+
+    std::string m_source;
+    std::vector<Op> m_ops;
+    size_t m_literalSize = 0;
+    size_t m_fieldCount = 0;
+};
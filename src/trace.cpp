@@ -0,0 +1,285 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Events are stored in fixed blocks linked by their owning thread. The owner is
+// the only writer; `count` and `next` are published with release ordering so
+// WriteJson can walk the chain concurrently.
+struct Block {
+    static constexpr size_t kCapacity = 4096;
+
+    std::array<TraceEvent, kCapacity> events;
+    std::atomic<size_t> count{0};
+    std::atomic<Block*> next{nullptr};
+};
+
+struct ThreadBuffer {
+    static constexpr size_t kMaxBlocks = 256;   // ~1M events per thread
+
+    uint32_t tid = 0;
+    std::atomic<const char*> name{nullptr};
+    Block* head = nullptr;
+    Block* tail = nullptr;
+    size_t blocks = 0;
+    std::atomic<uint64_t> dropped{0};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadBuffer*> buffers;
+    std::once_flag started;
+    Trace::clock::time_point origin;
+};
+
+// Never destroyed: threads still running during static destruction may record.
+Registry& GetRegistry()
+{
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+// Registers the calling thread the first time it records.
+ThreadBuffer& LocalBuffer()
+{
+    thread_local ThreadBuffer* buffer = [] {
+        auto* created = new ThreadBuffer;
+        created->head = created->tail = new Block;
+        created->blocks = 1;
+
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        created->tid = static_cast<uint32_t>(registry.buffers.size() + 1);
+        registry.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+void CopyDetail(TraceEvent& event, std::string_view detail)
+{
+    size_t length = std::min(detail.size(), event.detail.size() - 1);
+    std::copy_n(detail.data(), length, event.detail.data());
+    event.detail[length] = '\0';
+}
+
+void AppendJsonString(std::string& out, std::string_view text)
+{
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof escaped, "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+// Microseconds with nanosecond precision, as the format expects
+void AppendMicros(std::string& out, uint64_t ns)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%llu.%03llu",
+                  static_cast<unsigned long long>(ns / 1000), static_cast<unsigned long long>(ns % 1000));
+    out += buf;
+}
+
+void AppendEvent(std::string& out, const TraceEvent& event, uint32_t tid)
+{
+    out += "{\"name\":";
+    AppendJsonString(out, event.name);
+    out += ",\"cat\":\"fxf\",\"ph\":\"";
+    out += event.phase;
+    out += "\",\"pid\":1,\"tid\":";
+    out += std::to_string(tid);
+    out += ",\"ts\":";
+    AppendMicros(out, event.startNs);
+
+    if (event.phase == 'X') {
+        out += ",\"dur\":";
+        AppendMicros(out, event.durationNs);
+    } else if (event.phase == 'i') {
+        out += ",\"s\":\"t\"";
+    } else {
+        out += ",\"id\":";
+        out += std::to_string(event.id);
+    }
+
+    bool hasId = event.idName && (event.phase == 'X' || event.phase == 'i');
+    bool hasDetail = event.detail[0] != '\0';
+    if (hasId || hasDetail) {
+        out += ",\"args\":{";
+        if (hasId) {
+            AppendJsonString(out, event.idName);
+            out += ':';
+            out += std::to_string(event.id);
+        }
+        if (hasDetail) {
+            if (hasId) out += ',';
+            out += "\"detail\":";
+            AppendJsonString(out, event.detail.data());
+        }
+        out += '}';
+    }
+    out += '}';
+}
+
+}
+
+void Trace::Start()
+{
+    Registry& registry = GetRegistry();
+    std::call_once(registry.started, [&registry] { registry.origin = clock::now(); });
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Trace::SetThreadName(const char* name)
+{
+    LocalBuffer().name.store(name, std::memory_order_release);
+}
+
+uint64_t Trace::SinceStart(clock::time_point time)
+{
+    auto since = time - GetRegistry().origin;
+    return since.count() < 0 ? 0 : static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(since).count());
+}
+
+void Trace::Append(const TraceEvent& event)
+{
+    ThreadBuffer& buffer = LocalBuffer();
+    Block* block = buffer.tail;
+    size_t count = block->count.load(std::memory_order_relaxed);
+
+    if (count == Block::kCapacity) {
+        if (buffer.blocks == ThreadBuffer::kMaxBlocks) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Block* next = new Block;
+        block->next.store(next, std::memory_order_release);
+        buffer.tail = block = next;
+        ++buffer.blocks;
+        count = 0;
+    }
+
+    block->events[count] = event;
+    block->count.store(count + 1, std::memory_order_release);
+}
+
+void Trace::Complete(const char* name, clock::time_point start, clock::time_point end,
+                     const char* idName, uint64_t id, std::string_view detail)
+{
+    if (!Enabled()) return;
+    TraceEvent event;
+    event.name = name;
+    event.phase = 'X';
+    event.startNs = SinceStart(start);
+    event.durationNs = SinceStart(end) - event.startNs;
+    event.idName = idName;
+    event.id = id;
+    CopyDetail(event, detail);
+    Append(event);
+}
+
+void Trace::Instant(const char* name, std::string_view detail)
+{
+    if (!Enabled()) return;
+    TraceEvent event;
+    event.name = name;
+    event.phase = 'i';
+    event.startNs = SinceStart(clock::now());
+    CopyDetail(event, detail);
+    Append(event);
+}
+
+void Trace::AsyncBegin(const char* name, uint64_t id)
+{
+    if (!Enabled()) return;
+    TraceEvent event;
+    event.name = name;
+    event.phase = 'b';
+    event.startNs = SinceStart(clock::now());
+    event.id = id;
+    Append(event);
+}
+
+void Trace::AsyncEnd(const char* name, uint64_t id)
+{
+    if (!Enabled()) return;
+    TraceEvent event;
+    event.name = name;
+    event.phase = 'e';
+    event.startNs = SinceStart(clock::now());
+    event.id = id;
+    Append(event);
+}
+
+bool Trace::WriteJson(std::FILE* out)
+{
+    std::vector<ThreadBuffer*> buffers;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        buffers = registry.buffers;
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    bool ok = true;
+    auto separate = [&] {
+        if (!first) json += ",\n";
+        first = false;
+    };
+    auto flush = [&] {
+        if (std::fwrite(json.data(), 1, json.size(), out) != json.size()) ok = false;
+        json.clear();
+    };
+
+    uint64_t dropped = 0;
+    for (ThreadBuffer* buffer : buffers) {
+        separate();
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        json += std::to_string(buffer->tid);
+        json += ",\"args\":{\"name\":";
+        const char* name = buffer->name.load(std::memory_order_acquire);
+        AppendJsonString(json, name ? std::string(name) : "thread " + std::to_string(buffer->tid));
+        json += "}}";
+
+        for (Block* block = buffer->head; block; block = block->next.load(std::memory_order_acquire)) {
+            size_t count = block->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i) {
+                separate();
+                AppendEvent(json, block->events[i], buffer->tid);
+                if (json.size() >= (1 << 20)) flush();
+            }
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+
+    json += "\n],\"otherData\":{\"droppedEvents\":";
+    json += std::to_string(dropped);
+    json += "}}\n";
+    flush();
+    return ok && std::fflush(out) == 0;
+}
+
+bool Trace::WriteJson(const char* path)
+{
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file(std::fopen(path, "w"), std::fclose);
+    return file && WriteJson(file.get());
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+// Session timeline recorder (`fxf --trace <file>`). Each thread appends events
+// to its own buffer without locking; the buffers are written out once, as
+// Chrome trace-event JSON that chrome://tracing and Perfetto can open.
+
+struct TraceEvent {
+    static constexpr size_t kDetailSize = 40;
+
+    const char* name = "";                   // Static string
+    char phase = 'X';                        // X complete, i instant, b/e async begin/end
+    uint64_t startNs = 0;                    // Since Trace::Start()
+    uint64_t durationNs = 0;                 // X only
+    uint64_t id = 0;                         // Async id, or a numeric argument
+    const char* idName = nullptr;            // Argument name for `id` on X/i events
+    std::array<char, kDetailSize> detail{};  // Optional text argument, truncated
+};
+
+class Trace
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    static bool Enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Starts recording; timestamps are relative to the first Start().
+    static void Start();
+    static void Stop() { s_enabled.store(false, std::memory_order_relaxed); }
+
+    // Names the calling thread in the trace viewer (a static string).
+    static void SetThreadName(const char* name);
+
+    // Recording functions do nothing while tracing is off.
+    static void Complete(const char* name, clock::time_point start, clock::time_point end,
+                         const char* idName = nullptr, uint64_t id = 0, std::string_view detail = {});
+    static void Instant(const char* name, std::string_view detail = {});
+    static void AsyncBegin(const char* name, uint64_t id);
+    static void AsyncEnd(const char* name, uint64_t id);
+
+    // Writes every event recorded so far. Safe while other threads are still
+    // recording; their newest events may be left out.
+    static bool WriteJson(std::FILE* out);
+    static bool WriteJson(const char* path);
+
+private:
+    static void Append(const TraceEvent& event);
+    static uint64_t SinceStart(clock::time_point time);
+
+    static inline std::atomic<bool> s_enabled{false};
+};
+
+// Records its scope as a complete event while tracing is on.
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name, std::string_view detail = {})
+        : m_name(name)
+        , m_active(Trace::Enabled())
+    {
+        if (m_active) {
+            m_detail = detail;
+            m_start = Trace::clock::now();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (m_active) Trace::Complete(m_name, m_start, Trace::clock::now(), nullptr, 0, m_detail);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;
+    bool m_active;
+    std::string_view m_detail;
+    Trace::clock::time_point m_start;
+};
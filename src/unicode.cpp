@@ -0,0 +1,189 @@
+#include "unicode.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+struct Interval {
+    char32_t first;
+    char32_t last;
+};
+
+// Zero-width code points: combining marks, zero-width spaces/joiners, variation selectors.
+constexpr Interval kZeroWidth[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+    {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+    {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0900, 0x0902}, {0x093A, 0x093A},
+    {0x093C, 0x093C}, {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957},
+    {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1AB0, 0x1AFF},
+    {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064},
+    {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+    {0xE0001, 0xE0001}, {0xE0020, 0xE007F}, {0xE0100, 0xE01EF},
+};
+
+// East Asian Wide (W) and Fullwidth (F) code points, including emoji presentation.
+constexpr Interval kWide[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+    {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+    {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+    {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19},
+    {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+    {0x17000, 0x18AFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF},
+    {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F202}, {0x1F210, 0x1F23B},
+    {0x1F240, 0x1F248}, {0x1F250, 0x1F251}, {0x1F260, 0x1F265}, {0x1F300, 0x1F320},
+    {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA},
+    {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0}, {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F43E},
+    {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D}, {0x1F54B, 0x1F54E},
+    {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4},
+    {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2},
+    {0x1F6D5, 0x1F6D7}, {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7EB},
+    {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+    {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+template <size_t N>
+bool InTable(const Interval (&table)[N], char32_t cp)
+{
+    if (cp < table[0].first || cp > table[N - 1].last) return false;
+    auto it = std::upper_bound(std::begin(table), std::end(table), cp,
+        [](char32_t value, const Interval& interval) { return value < interval.first; });
+    return it != std::begin(table) && cp <= std::prev(it)->last;
+}
+
+// Decodes one UTF-8 sequence at the start of text (which must be non-empty).
+// Returns the number of bytes consumed; invalid input consumes one byte as U+FFFD.
+size_t DecodeUtf8(std::string_view text, char32_t& cp)
+{
+    const auto* s = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+
+    size_t length = 0;
+    char32_t min = 0;
+    if (s[0] < 0x80)      { cp = s[0]; return 1; }
+    else if (s[0] < 0xC0) { cp = 0xFFFD; return 1; }
+    else if (s[0] < 0xE0) { length = 2; cp = s[0] & 0x1F; min = 0x80; }
+    else if (s[0] < 0xF0) { length = 3; cp = s[0] & 0x0F; min = 0x800; }
+    else if (s[0] < 0xF8) { length = 4; cp = s[0] & 0x07; min = 0x10000; }
+    else                  { cp = 0xFFFD; return 1; }
+
+    if (n < length) { cp = 0xFFFD; return 1; }
+    for (size_t i = 1; i < length; ++i) {
+        if ((s[i] & 0xC0) != 0x80) { cp = 0xFFFD; return 1; }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        cp = 0xFFFD;
+        return 1;
+    }
+    return length;
+}
+
+}
+
+int CodepointWidth(char32_t cp)
+{
+    if (cp < 0x7F) return 1;
+    if (cp < 0xA0) return 0;   // DEL and C1 controls
+    if (InTable(kZeroWidth, cp)) return 0;
+    if (InTable(kWide, cp)) return 2;
+    return 1;
+}
+
+size_t AsciiPrefixLength(const char* data, size_t size)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(chunk));
+        if (mask != 0) return i + std::countr_zero(mask);
+    }
+#endif
+    if constexpr (std::endian::native == std::endian::little) {
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof word);
+            uint64_t high = word & 0x8080808080808080ULL;
+            if (high != 0) return i + std::countr_zero(high) / 8;
+        }
+    }
+    for (; i < size; ++i) {
+        if (static_cast<unsigned char>(data[i]) & 0x80) return i;
+    }
+    return size;
+}
+
+size_t ValidUtf8Length(std::string_view text)
+{
+    size_t valid = 0;
+    while (valid < text.size()) {
+        valid += AsciiPrefixLength(text.data() + valid, text.size() - valid);
+        if (valid == text.size()) break;
+
+        // DecodeUtf8 consumes a single byte only for invalid input; an encoded
+        // U+FFFD is three bytes long.
+        char32_t cp;
+        size_t length = DecodeUtf8(text.substr(valid), cp);
+        if (cp == 0xFFFD && length == 1) break;
+        valid += length;
+    }
+    return valid;
+}
+
+size_t DisplayWidth(std::string_view text)
+{
+    size_t width = 0;
+    while (!text.empty()) {
+        size_t ascii = AsciiPrefixLength(text.data(), text.size());
+        width += ascii;
+        text.remove_prefix(ascii);
+        if (text.empty()) break;
+
+        char32_t cp;
+        text.remove_prefix(DecodeUtf8(text, cp));
+        width += CodepointWidth(cp);
+    }
+    return width;
+}
+
+WidthCut CutToWidth(std::string_view text, size_t maxWidth)
+{
+    WidthCut cut;
+    while (cut.bytes < text.size()) {
+        std::string_view rest = text.substr(cut.bytes);
+
+        if (size_t ascii = AsciiPrefixLength(rest.data(), rest.size()); ascii > 0) {
+            size_t take = std::min(ascii, maxWidth - cut.width);
+            cut.bytes += take;
+            cut.width += take;
+            if (take < ascii) break;
+            continue;
+        }
+
+        // Zero-width marks still fit once the budget is used up, so they stay
+        // attached to the glyph they modify.
+        char32_t cp;
+        size_t length = DecodeUtf8(rest, cp);
+        size_t width = CodepointWidth(cp);
+        if (cut.width + width > maxWidth) break;
+        cut.bytes += length;
+        cut.width += width;
+    }
+    return cut;
+}
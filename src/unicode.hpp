@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// Terminal column width of a code point: 0 for combining marks and other
+// zero-width characters, 2 for East Asian wide/fullwidth and emoji, else 1.
+int CodepointWidth(char32_t cp);
+
+// Length of the leading run of ASCII bytes in [data, data + size).
+size_t AsciiPrefixLength(const char* data, size_t size);
+
+// Length of the longest prefix of text that is valid UTF-8.
+size_t ValidUtf8Length(std::string_view text);
+
+// Display width of UTF-8 text. Invalid bytes count as one column each.
+size_t DisplayWidth(std::string_view text);
+
+struct WidthCut {
+    size_t bytes = 0;   // Length of the prefix, always on a code point boundary
+    size_t width = 0;   // Display width of that prefix
+};
+
+// Longest prefix of text that fits in maxWidth columns.
+WidthCut CutToWidth(std::string_view text, size_t maxWidth);
@@ -1,10 +1,9 @@
 #include "utils.hpp"
+#include "template.hpp"
 
 #include <ranges>
-#include <memory>
-#include <regex>
-#include <unistd.h>
-#include <sys/wait.h>
+#include <cstring>
+#include <cctype>
 
 using namespace ftxui;
 
@@ -66,119 +65,124 @@ std::string EventToString(const Event& event) {
     return "unknown";
 }
 
-std::string ExecAndCapture(const std::string& cmd) {
-    char buffer[128];
-    std::string result = "";
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
+std::string substitute_template(std::string_view template_str, const std::vector<std::string>& data) {
+    return CompiledTemplate(template_str).Render(data);
+}
 
-    if (!pipe) {
-        throw std::runtime_error("popen() failed!");
-    }
+std::string trim(std::string_view str) {
+    const auto first = str.find_first_not_of(" \t\n\r\f\v");
+    if (first == std::string_view::npos)
+        return ""; // all whitespace
+    const auto last = str.find_last_not_of(" \t\n\r\f\v");
+    return std::string{str.substr(first, (last - first + 1))};
+}
+
+std::vector<size_t> IndexLines(std::string_view text) {
+    std::vector<size_t> starts;
+    ExtendLineIndex(starts, text, 0);
+    return starts;
+}
 
-    while (fgets(buffer, sizeof buffer, pipe.get()) != nullptr) {
-        result += buffer;
+void ExtendLineIndex(std::vector<size_t>& starts, std::string_view text, size_t from) {
+    if (from >= text.size()) return;
+
+    // The appended bytes open a new line unless they continue an unterminated one.
+    if (from == 0 || text[from - 1] == '\n') starts.push_back(from);
+
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (const char* p = begin + from; (p = static_cast<const char*>(std::memchr(p, '\n', end - p))) != nullptr;) {
+        ++p;
+        if (p == end) break;
+        starts.push_back(static_cast<size_t>(p - begin));
     }
+}
 
-    return result;
+namespace {
+
+// Character classes of the URL grammar:
+//   https?://  [-a-zA-Z0-9@:%._+~#=]{1,256}  \.  [a-zA-Z0-9()]{1,6}  \b  [-a-zA-Z0-9()@:%_+.~#?&/=]*
+bool IsUrlHostChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || std::strchr("-@:%._+~#=", c) != nullptr;
 }
 
-std::string substitute_template(std::string_view template_str, const std::vector<std::string>& data) {
-    std::string result;
-    result.reserve(template_str.size() * 2);
-
-    std::string joined_data;
-    bool joined_computed = false;
-
-    size_t i = 0;
-    while (i < template_str.size()) {
-        if (template_str[i] == '{') {
-            size_t close = template_str.find('}', i + 1);
-            if (close != std::string_view::npos) {
-                std::string_view inner = template_str.substr(i + 1, close - i - 1);
-
-                if (inner.empty()) {
-                    // {} placeholder - lazy compute joined_data
-                    if (!joined_computed) {
-                        if (!data.empty()) {
-                            size_t total_len = data[0].size();
-                            for (size_t j = 1; j < data.size(); ++j) {
-                                total_len += 3 + data[j].size();
-                            }
-                            joined_data.reserve(total_len);
-                            joined_data = data[0];
-                            for (size_t j = 1; j < data.size(); ++j) {
-                                joined_data += " | ";
-                                joined_data += data[j];
-                            }
-                        }
-                        joined_computed = true;
-                    }
-                    result += joined_data;
-                } else {
-                    // Parse {N} placeholder
-                    size_t idx = 0;
-                    bool valid = true;
-                    for (char c : inner) {
-                        if (c >= '0' && c <= '9') {
-                            idx = idx * 10 + (c - '0');
-                        } else {
-                            valid = false;
-                            break;
-                        }
-                    }
-
-                    if (valid && idx < data.size()) {
-                        result += data[idx];
-                    } else {
-                        result.append(template_str.substr(i, close - i + 1));
-                    }
-                }
-                i = close + 1;
-                continue;
-            }
+bool IsUrlTopLevelChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '(' || c == ')';
+}
+
+bool IsUrlChar(char c)
+{
+    return IsUrlHostChar(c) || std::strchr("()?&/", c) != nullptr;
+}
+
+bool IsWordChar(std::string_view text, size_t pos)
+{
+    return pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_');
+}
+
+bool StartsWithNoCase(std::string_view text, size_t pos, std::string_view prefix)
+{
+    if (text.size() - pos < prefix.size()) return false;
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[pos + i])) != prefix[i]) return false;
+    }
+    return true;
+}
+
+// True if a host of 1-256 host characters, a dot and a 1-6 character
+// top-level part ending on a word boundary start at `host`.
+bool HasUrlHost(std::string_view text, size_t host)
+{
+    size_t hostEnd = host;
+    while (hostEnd < text.size() && hostEnd - host < 257 && IsUrlHostChar(text[hostEnd])) ++hostEnd;
+
+    for (size_t dot = host + 1; dot < hostEnd && dot - host <= 256; ++dot) {
+        if (text[dot] != '.') continue;
+        for (size_t end = dot + 1; end < text.size() && end - dot <= 6 && IsUrlTopLevelChar(text[end]); ++end) {
+            if (IsWordChar(text, end) != IsWordChar(text, end + 1)) return true;
         }
-        result += template_str[i];
-        ++i;
     }
+    return false;
+}
 
-    return result;
 }
 
-std::string trim(std::string_view str) {
-    const auto first = str.find_first_not_of(" \t\n\r\f\v");
-    if (first == std::string_view::npos)
-        return ""; // all whitespace
-    const auto last = str.find_last_not_of(" \t\n\r\f\v");
-    return std::string{str.substr(first, (last - first + 1))};
+std::string_view FindURL(std::string_view text, size_t from)
+{
+    for (size_t pos = text.find_first_of("hH", from); pos != std::string_view::npos;
+         pos = text.find_first_of("hH", pos + 1)) {
+        size_t host;
+        if (StartsWithNoCase(text, pos, "https://")) {
+            host = pos + 8;
+        } else if (StartsWithNoCase(text, pos, "http://")) {
+            host = pos + 7;
+        } else {
+            continue;
+        }
+        if (!HasUrlHost(text, host)) continue;
+
+        // Host and top-level part are URL characters too, so the match runs
+        // to the end of the URL characters after the scheme.
+        size_t end = host;
+        while (end < text.size() && IsUrlChar(text[end])) ++end;
+        return text.substr(pos, end - pos);
+    }
+    return {};
 }
 
 std::vector<std::string> ExtractURLs(const std::string& text) {
-    static const std::regex url_regex(
-        R"((https?://(?:www\.)?[-a-zA-Z0-9@:%._+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b(?:[-a-zA-Z0-9()@:%_+.~#?&/=]*)))",
-        std::regex::icase
-    );
-
     std::vector<std::string> urls;
-    auto begin = std::sregex_iterator(text.begin(), text.end(), url_regex);
-    auto end = std::sregex_iterator();
-
-    for (auto it = begin; it != end; ++it) {
-        urls.push_back(it->str());
+    for (std::string_view url = FindURL(text); !url.empty();
+         url = FindURL(text, url.data() - text.data() + url.size())) {
+        urls.emplace_back(url);
     }
     return urls;
 }
 
 std::string ExtractFirstURL(const std::string& text) {
-    static const std::regex url_regex(
-        R"((https?://(?:www\.)?[-a-zA-Z0-9@:%._+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b(?:[-a-zA-Z0-9()@:%_+.~#?&/=]*)))",
-        std::regex::icase
-    );
-
-    std::smatch match;
-    if (std::regex_search(text, match, url_regex)) {
-        return match.str(0);
-    }
-    return {};
+    return std::string(FindURL(text));
 }
 
 std::vector<std::string> SplitCommand(std::string_view cmd) {
@@ -227,32 +231,3 @@ std::vector<std::string> SplitCommand(std::string_view cmd) {
 
     return args;
 }
-
-int ExecNoShell(std::string_view cmd) {
-    auto args = SplitCommand(cmd);
-    if (args.empty()) return -1;
-
-    std::vector<char*> argv;
-    for (auto& arg : args) {
-        argv.push_back(arg.data());
-    }
-    argv.push_back(nullptr);
-
-    pid_t pid = fork();
-    if (pid == -1) {
-        return -1;
-    }
-
-    if (pid == 0) {
-        execvp(argv[0], argv.data());
-        _exit(127);
-    }
-
-    int status;
-    waitpid(pid, &status, 0);
-
-    if (WIFEXITED(status)) {
-        return WEXITSTATUS(status);
-    }
-    return -1;
-}
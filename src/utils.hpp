@@ -10,15 +10,26 @@ std::vector<std::string> split_csv_line(std::string_view line, char delimiter =
 std::vector<std::string_view> split_csv_line_view(std::string_view line, char delimiter = ',');
 std::string EventToString(const ftxui::Event& event);
 
-std::string ExecAndCapture(const std::string& cmd);
 std::string substitute_template(std::string_view template_str, const std::vector<std::string>& data);
 std::string trim(std::string_view str);
 
+// Byte offset of the start of each line in text (a trailing newline does not start a new line)
+std::vector<size_t> IndexLines(std::string_view text);
+
+// Turns starts, the IndexLines() of text's first `from` bytes, into that of all
+// of text. Lets text that grows by appending be indexed one piece at a time.
+void ExtendLineIndex(std::vector<size_t>& starts, std::string_view text, size_t from);
+
+// First http(s) URL in text at or after `from`, or an empty view. Scans by
+// hand what the case-insensitive regex
+//   https?://[-a-zA-Z0-9@:%._+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b[-a-zA-Z0-9()@:%_+.~#?&/=]*
+// would match.
+std::string_view FindURL(std::string_view text, size_t from = 0);
+
 std::vector<std::string> ExtractURLs(const std::string& text);
 std::string ExtractFirstURL(const std::string& text);
 
 std::vector<std::string> SplitCommand(std::string_view cmd);
-int ExecNoShell(std::string_view cmd);
 
 // Smart case: case-insensitive if query is all lowercase, case-sensitive if any uppercase
 inline bool hasUppercase(std::string_view str) {
@@ -31,12 +42,15 @@ inline std::string toLower(std::string_view str) {
     return result;
 }
 
-// Returns vector of (original_index, score) pairs for choices that pass the cutoff
+// Replaces results with (original_index, score) pairs for choices that pass the
+// cutoff. `lowered` is scratch space for case-insensitive matching; reusing
+// results and lowered across calls avoids allocating per choice.
 template <typename Sentence1, typename Iterable>
-std::vector<std::pair<size_t, double>>
-extract(const Sentence1& query, const Iterable& choices, const double score_cutoff = 70.0)
+void extract_into(const Sentence1& query, const Iterable& choices,
+                  std::vector<std::pair<size_t, double>>& results, std::string& lowered,
+                  const double score_cutoff = 70.0)
 {
-    std::vector<std::pair<size_t, double>> results;
+    results.clear();
 
     bool caseSensitive = hasUppercase(query);
 
@@ -55,14 +69,24 @@ extract(const Sentence1& query, const Iterable& choices, const double score_cuto
         rapidfuzz::fuzz::CachedPartialRatio<char> scorer(lowerQuery);
         size_t idx = 0;
         for (const auto& choice : choices) {
-            std::string lowerChoice = toLower(choice);
-            double score = scorer.similarity(lowerChoice, score_cutoff);
+            lowered.resize(choice.size());
+            std::ranges::transform(choice, lowered.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            double score = scorer.similarity(lowered, score_cutoff);
             if (score >= score_cutoff) {
                 results.emplace_back(idx, score);
             }
             ++idx;
         }
     }
+}
 
+// Returns vector of (original_index, score) pairs for choices that pass the cutoff
+template <typename Sentence1, typename Iterable>
+std::vector<std::pair<size_t, double>>
+extract(const Sentence1& query, const Iterable& choices, const double score_cutoff = 70.0)
+{
+    std::vector<std::pair<size_t, double>> results;
+    std::string lowered;
+    extract_into(query, choices, results, lowered, score_cutoff);
     return results;
 }
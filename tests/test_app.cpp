@@ -1,15 +1,25 @@
 #include <catch2/catch_test_macros.hpp>
 #include "app.hpp"
+#include "alloc_hook.hpp"
+#include "datagen.hpp"
 
 // Helper to reset App state between tests
 static void ResetAppState() {
     auto& app = App::Instance();
-    app.state.lines.data.clear();
+    app.CloseGroups();
+    app.state.lines.Clear();
+    app.controls.baseIndices.clear();
     app.controls.filteredIndices.clear();
     app.controls.menuEntries.clear();
-    app.controls.selections.clear();
+    app.cache.menuEntries.clear();
+    app.controls.searchDialog.string.clear();
+    app.controls.selections.Clear();
     app.controls.selected = 0;
     app.controls.viewTemplate = "{}";
+    app.controls.filters.clear();
+    app.controls.sortSpec.reset();
+    app.controls.previewCommand.clear();
+    app.scope.SetPreviewHelper("");
     // Ensure commands are registered (idempotent - won't double-register)
     app.commands.RegisterDefaultCommands();
 }
@@ -137,3 +147,296 @@ TEST_CASE("GetOriginalIndex bounds checking", "[app]") {
         CHECK_FALSE(app.GetOriginalIndex(100).has_value());
     }
 }
+
+TEST_CASE("Selections track original indices", "[app][selection]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    for (const char* row : {"row0", "row1", "row2", "row3", "row4"}) {
+        app.state.lines.AddLine(row, '|');
+    }
+
+    SECTION("select-all and invert over every row") {
+        app.controls.filteredIndices = {0, 1, 2, 3, 4};
+        app.ToggleSelection(1);
+        app.InvertSelections();
+        CHECK(app.controls.selections.Count() == 4);
+        CHECK_FALSE(app.IsSelected(1));
+        app.SelectAll();
+        CHECK(app.controls.selections.Count() == 5);
+    }
+
+    SECTION("select-all and invert over a filtered subset") {
+        app.controls.filteredIndices = {4, 2};
+        app.SelectAll();
+        CHECK(app.controls.selections.Count() == 2);
+        CHECK(app.controls.selections.Test(4));
+        CHECK(app.controls.selections.Test(2));
+
+        app.controls.filteredIndices = {4, 3};
+        app.InvertSelections();
+        CHECK(app.controls.selections.Test(2));
+        CHECK(app.controls.selections.Test(3));
+        CHECK_FALSE(app.controls.selections.Test(4));
+    }
+
+    SECTION("delete shifts selections above the deleted row") {
+        app.controls.filteredIndices = {0, 1, 2, 3, 4};
+        app.ReapplyViewTemplate();
+        app.ToggleSelection(1);
+        app.ToggleSelection(3);
+        app.controls.selected = 2;
+
+        app.commands.Execute("delete");
+
+        CHECK(app.controls.selections.Count() == 2);
+        CHECK(app.controls.selections.Test(1));
+        CHECK(app.controls.selections.Test(2));
+    }
+}
+
+TEST_CASE("Sort command reorders the view", "[app][sort]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    for (const char* row : {"b|10", "a|9", "c|100"}) {
+        app.state.lines.AddLine(row, '|');
+    }
+    app.ResetView();
+    app.ToggleSelection(0);
+
+    SECTION("numeric descending") {
+        REQUIRE(app.commands.Execute("sort 1 numeric desc"));
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{2, 0, 1});
+        CHECK(app.controls.menuEntries.front() == "c | 100");
+    }
+
+    SECTION("sorted order survives a filter reset") {
+        REQUIRE(app.commands.Execute("sort 0"));
+        app.ResetFilter();
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{1, 0, 2});
+    }
+
+    SECTION("rows and selections are untouched") {
+        REQUIRE(app.commands.Execute("sort 0 desc"));
+        CHECK(app.state.lines[0][0] == "b");
+        CHECK(app.controls.selections.Test(0));
+    }
+
+    SECTION("bad arguments fail") {
+        CHECK_FALSE(app.commands.Execute("sort"));
+        CHECK_FALSE(app.commands.Execute("sort x"));
+    }
+}
+
+TEST_CASE("Bound commands substitute the row under the cursor", "[app][sort]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    for (const char* row : {"b|10", "a|9", "c|100"}) {
+        app.state.lines.AddLine(row, '|');
+    }
+    app.ResetView();
+    REQUIRE(app.commands.Execute("command show-first modal printf %s {0}"));
+
+    // The cursor is on the first displayed row, not on row 0 of the table
+    REQUIRE(app.commands.Execute("sort 1 numeric desc"));
+    app.controls.selected = 0;
+    REQUIRE(app.commands.Execute("show-first"));
+    CHECK(app.controls.display.string == "c");
+
+    app.controls.selected = 2;
+    REQUIRE(app.commands.Execute("show-first"));
+    CHECK(app.controls.display.string == "a");
+
+    // No row, nothing to run
+    app.controls.display.string.clear();
+    app.controls.filteredIndices.clear();
+    CHECK_FALSE(app.commands.Execute("show-first"));
+    CHECK(app.controls.display.string.empty());
+    app.controls.display.isActive = false;
+}
+
+TEST_CASE("Where command filters the base view", "[app][where]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    for (const char* row : {"a|700", "b|20", "c|900", "d|x"}) {
+        app.state.lines.AddLine(row, '|');
+    }
+    app.ResetView();
+
+    SECTION("filter, then reset keeps the filter") {
+        REQUIRE(app.commands.Execute("where 1 > 100"));
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{0, 2});
+        app.ResetFilter();
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{0, 2});
+    }
+
+    SECTION("filters compose with sort and with each other") {
+        REQUIRE(app.commands.Execute("sort 1 numeric desc"));
+        REQUIRE(app.commands.Execute("where 1 > 100"));
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{2, 0});
+        REQUIRE(app.commands.Execute("where 0 == a"));
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{0});
+    }
+
+    SECTION("where without arguments clears filters but keeps the sort") {
+        REQUIRE(app.commands.Execute("sort 0 desc"));
+        REQUIRE(app.commands.Execute("where 1 > 100"));
+        REQUIRE(app.commands.Execute("where"));
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{3, 2, 1, 0});
+    }
+
+    SECTION("bad predicate fails") {
+        CHECK_FALSE(app.commands.Execute("where 1 >"));
+    }
+}
+
+TEST_CASE("Group command shows groups and drills down", "[app][group]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    for (const char* row : {"web|10", "db|5", "web|30", "db|1", "web|2"}) {
+        app.state.lines.AddLine(row, '|');
+    }
+    app.ResetView();
+
+    REQUIRE(app.commands.Execute("group 0 1"));
+    REQUIRE(app.groupView.isActive);
+    REQUIRE(app.controls.menuEntries.size() == 2);
+    CHECK(app.controls.menuEntries[0] == "web | 3 | 42 | 2 | 30");
+
+    SECTION("select drills into the focused group") {
+        app.controls.selected = 1;
+        REQUIRE(app.commands.Execute("select"));
+        CHECK_FALSE(app.groupView.isActive);
+        CHECK(app.state.lines.data.size() == 5);
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{1, 3});
+    }
+
+    SECTION("ungroup restores the previous view") {
+        REQUIRE(app.commands.Execute("ungroup"));
+        CHECK(app.controls.filteredIndices == std::vector<size_t>{0, 1, 2, 3, 4});
+        CHECK_FALSE(app.commands.Execute("ungroup"));
+    }
+}
+
+TEST_CASE("Ungroup restores a searched view", "[app][group][search]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    for (const char* row : {"web|10", "db|5", "web|30", "db|1", "web|2"}) {
+        app.state.lines.AddLine(row, '|');
+    }
+    app.ResetView();
+    app.controls.searchDialog.string = "db";
+    app.ApplySearch();
+    const std::vector<size_t> searched = app.controls.filteredIndices;
+    REQUIRE(searched.size() == 2);
+
+    REQUIRE(app.commands.Execute("group 0"));
+    CHECK(app.controls.searchDialog.string.empty());
+    REQUIRE(app.controls.menuEntries.size() == 1);   // Only the searched rows were grouped
+
+    REQUIRE(app.commands.Execute("ungroup"));
+    CHECK(app.controls.searchDialog.string == "db");
+    CHECK(app.controls.filteredIndices == searched);
+
+    // Clearing the restored query widens the view again.
+    app.controls.searchDialog.string.clear();
+    app.ApplySearch();
+    CHECK(app.controls.filteredIndices.size() == 5);
+}
+
+TEST_CASE("Search keystrokes do not allocate per row", "[app][search][alloc]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    DataGenerator generator({.shape = DataShape::Vimgrep, .rows = 5000});
+    for (std::string line; generator.AppendNext(line); line.clear()) {
+        app.state.lines.AddLine(line, ':');
+    }
+    app.ResetView();
+    app.BuildSearchLabels();
+
+    const std::vector<std::string> keystrokes = {"s", "sr", "src", "src/", "src", "sr", "s", ""};
+    auto typeAll = [&] {
+        for (const std::string& query : keystrokes) {
+            app.controls.searchDialog.string = query;
+            app.ApplySearch();
+        }
+    };
+
+    typeAll();
+    AllocationCounter counter;
+    typeAll();
+
+    CHECK(counter.Count() < keystrokes.size() * 8);
+    CHECK(app.controls.menuEntries.size() == 5000);
+    CHECK(app.controls.menuEntries[0] == app.cache.menuEntries[app.controls.filteredIndices[0]]);
+}
+
+TEST_CASE("Search labels are rebuilt when rows change but their count does not", "[app][search]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    for (const char* line : {"alpha", "beta", "gamma"}) app.state.lines.AddLine(line, '|');
+    app.ResetView();
+    app.BuildSearchLabels();
+    app.RefreshFilteredView();
+    CHECK(app.controls.menuEntries[0] == "alpha");
+
+    // A reload with as many rows as before
+    app.state.lines.Clear();
+    for (const char* line : {"delta", "epsilon", "zeta"}) app.state.lines.AddLine(line, '|');
+    app.RefreshFilteredView();
+    CHECK(app.controls.menuEntries[0] == "delta");
+
+    app.controls.searchDialog.string = "eps";
+    app.ApplySearch();
+    REQUIRE_FALSE(app.controls.filteredIndices.empty());
+    CHECK(app.controls.menuEntries[0] == "epsilon");
+    CHECK(app.cache.menuEntries == std::vector<std::string>{"delta", "epsilon", "zeta"});
+}
+
+TEST_CASE("Streamed preview output replaces the placeholder", "[app][preview]") {
+    ResetAppState();
+    auto& app = App::Instance();
+
+    app.SetPreviewContent("Loading...");
+    app.controls.preview.loading = true;
+
+    app.AppendPreviewContent("line 1\nline");
+    CHECK_FALSE(app.controls.preview.loading);
+    CHECK(app.controls.preview.content == "line 1\nline");
+    CHECK(app.controls.preview.lineStarts == std::vector<size_t>{0, 7});
+
+    app.AppendPreviewContent(" 2\nline 3\n");
+    CHECK(app.controls.preview.content == "line 1\nline 2\nline 3\n");
+    CHECK(app.controls.preview.lineStarts == std::vector<size_t>{0, 7, 14});
+
+    app.SetPreviewContent("");
+}
+
+TEST_CASE("Preview commands are substituted per row", "[app][preview]") {
+    ResetAppState();
+    auto& app = App::Instance();
+    app.state.lines.AddLine("src/a.cpp|12", '|');
+    app.state.lines.AddLine("src/b.cpp|7", '|');
+
+    CHECK_FALSE(app.PreviewsByCommand());
+    CHECK(app.PreviewSource(1) == "src/b.cpp 7");
+
+    app.controls.previewCommand = "bat -r {1}: {0}";
+    CHECK(app.PreviewsByCommand());
+    CHECK(app.PreviewSource(0) == "bat -r 12: src/a.cpp");
+    CHECK(app.PreviewSource(1) == "bat -r 7: src/b.cpp");
+
+    // A helper alone is sent the row text
+    app.controls.previewCommand.clear();
+    app.scope.SetPreviewHelper("cat");
+    CHECK(app.PreviewsByCommand());
+    CHECK(app.PreviewSource(0) == "src/a.cpp 12");
+    app.scope.SetPreviewHelper("");
+}
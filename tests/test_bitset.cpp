@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bitset.hpp"
+
+static std::vector<size_t> SetBits(const DynamicBitset& bits)
+{
+    std::vector<size_t> result;
+    bits.ForEachSet([&](size_t pos) { result.push_back(pos); });
+    return result;
+}
+
+TEST_CASE("DynamicBitset single-bit operations", "[bitset]") {
+    DynamicBitset bits;
+    CHECK(bits.Size() == 0);
+    CHECK(bits.None());
+    CHECK_FALSE(bits.Test(10));
+
+    SECTION("Set grows the bitset") {
+        bits.Set(100);
+        CHECK(bits.Size() == 101);
+        CHECK(bits.Test(100));
+        CHECK_FALSE(bits.Test(99));
+        CHECK(bits.Count() == 1);
+    }
+
+    SECTION("Flip toggles") {
+        bits.Flip(3);
+        CHECK(bits.Test(3));
+        bits.Flip(3);
+        CHECK_FALSE(bits.Test(3));
+    }
+
+    SECTION("Reset out of range is a no-op") {
+        bits.Reset(1000);
+        CHECK(bits.Size() == 0);
+    }
+}
+
+TEST_CASE("DynamicBitset bulk operations", "[bitset]") {
+    DynamicBitset bits;
+    bits.Resize(130);
+
+    SECTION("SetAll respects the size") {
+        bits.SetAll();
+        CHECK(bits.Count() == 130);
+        CHECK_FALSE(bits.Test(130));
+    }
+
+    SECTION("FlipAll inverts") {
+        bits.Set(0);
+        bits.Set(64);
+        bits.FlipAll();
+        CHECK(bits.Count() == 128);
+        CHECK_FALSE(bits.Test(0));
+        CHECK_FALSE(bits.Test(64));
+        CHECK(bits.Test(129));
+    }
+
+    SECTION("Clear keeps the size") {
+        bits.SetAll();
+        bits.Clear();
+        CHECK(bits.None());
+        CHECK(bits.Size() == 130);
+    }
+
+    SECTION("shrinking drops high bits") {
+        bits.SetAll();
+        bits.Resize(70);
+        CHECK(bits.Count() == 70);
+        bits.Resize(130);
+        CHECK(bits.Count() == 70);
+    }
+}
+
+TEST_CASE("DynamicBitset ForEachSet visits in order", "[bitset]") {
+    DynamicBitset bits;
+    for (size_t pos : {200, 0, 63, 64, 65}) bits.Set(pos);
+    CHECK(SetBits(bits) == std::vector<size_t>{0, 63, 64, 65, 200});
+}
+
+TEST_CASE("DynamicBitset EraseAndShift", "[bitset]") {
+    DynamicBitset bits;
+    for (size_t pos : {1, 5, 63, 64, 127, 128}) bits.Set(pos);
+
+    SECTION("erase a set bit") {
+        bits.EraseAndShift(5);
+        CHECK(bits.Size() == 128);
+        CHECK(SetBits(bits) == std::vector<size_t>{1, 62, 63, 126, 127});
+    }
+
+    SECTION("erase an unset bit below everything") {
+        bits.EraseAndShift(0);
+        CHECK(SetBits(bits) == std::vector<size_t>{0, 4, 62, 63, 126, 127});
+    }
+
+    SECTION("erase at a word boundary") {
+        bits.EraseAndShift(63);
+        CHECK(SetBits(bits) == std::vector<size_t>{1, 5, 63, 126, 127});
+    }
+
+    SECTION("erase the last bit") {
+        bits.EraseAndShift(128);
+        CHECK(SetBits(bits) == std::vector<size_t>{1, 5, 63, 64, 127});
+    }
+}
@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+#include "coprocess.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+// Answers every request with its payload in brackets. `before` runs ahead of
+// each answer; `after` once a request is answered.
+static std::string EchoHelper(const std::string& before = "", const std::string& after = "")
+{
+    return "while read n; do p=$(head -c \"$n\"); " + before + " out=\"[$p]\"; "
+           "printf '%s\\n%s' \"${#out}\" \"$out\"; " + after + " done";
+}
+
+TEST_CASE("Coprocess answers requests from one helper", "[coprocess]") {
+    Coprocess helper(EchoHelper());
+    CHECK(helper.Pid() == 0);
+
+    CHECK(helper.Request("first") == "[first]");
+    pid_t pid = helper.Pid();
+    CHECK(pid > 0);
+
+    CHECK(helper.Request("second line\nwith a newline") == "[second line\nwith a newline]");
+    CHECK(helper.Request("") == "[]");
+    CHECK(helper.Pid() == pid);
+    CHECK(helper.Starts() == 1);
+}
+
+TEST_CASE("Coprocess streams responses and stops when asked", "[coprocess]") {
+    Coprocess helper(EchoHelper());
+
+    std::string seen;
+    bool truncated = true;
+    auto response = helper.Request("streamed", {}, [&](std::string_view chunk) {
+        seen += chunk;
+        return true;
+    }, &truncated);
+    CHECK(response == "[streamed]");
+    CHECK(seen == "[streamed]");
+    CHECK_FALSE(truncated);
+
+    SECTION("declining more skips the rest of the response") {
+        const std::string big(200'000, 'x');
+        size_t calls = 0;
+        response = helper.Request(big, {}, [&](std::string_view) { return ++calls < 1; }, &truncated);
+        REQUIRE(response.has_value());
+        CHECK(calls == 1);
+        CHECK(response->size() < big.size() + 2);
+        CHECK(truncated);
+
+        // The next request gets its own answer, not the leftovers
+        CHECK(helper.Request("next") == "[next]");
+        CHECK(helper.Starts() == 1);
+    }
+}
+
+TEST_CASE("Coprocess restarts a helper that died", "[coprocess]") {
+    // Exits after every answer
+    Coprocess helper(EchoHelper("", "exit;"));
+
+    CHECK(helper.Request("one") == "[one]");
+    CHECK(helper.Request("two") == "[two]");
+    CHECK(helper.Request("three") == "[three]");
+    CHECK(helper.Starts() == 3);
+
+    SECTION("a helper that never answers is an error") {
+        Coprocess broken("exit 0");
+        auto failed = broken.Request("x");
+        REQUIRE_FALSE(failed.has_value());
+        CHECK(failed.error().find("exited") != std::string::npos);
+        CHECK(broken.Starts() == 2);
+    }
+}
+
+TEST_CASE("Coprocess times out and recovers", "[coprocess]") {
+    Coprocess silent("cat > /dev/null", 200ms);
+    auto start = std::chrono::steady_clock::now();
+    auto response = silent.Request("anyone?");
+    REQUIRE_FALSE(response.has_value());
+    CHECK(response.error().find("timed out") != std::string::npos);
+    CHECK(std::chrono::steady_clock::now() - start < 2s);
+    CHECK(silent.Pid() == 0);
+
+    SECTION("malformed frames kill the helper") {
+        Coprocess garbage("read n; echo not-a-number");
+        auto failed = garbage.Request("x");
+        REQUIRE_FALSE(failed.has_value());
+        CHECK(failed.error().find("Malformed") != std::string::npos);
+        CHECK(garbage.Pid() == 0);
+    }
+}
+
+TEST_CASE("Coprocess skips answers to abandoned requests", "[coprocess][threads]") {
+    Coprocess helper(EchoHelper("sleep 0.3;"));
+
+    std::stop_source source;
+    std::jthread stopper([&] {
+        std::this_thread::sleep_for(50ms);
+        source.request_stop();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK(helper.Request("abandoned", source.get_token()) == "");
+    CHECK(std::chrono::steady_clock::now() - start < 250ms);
+
+    CHECK(helper.Request("wanted") == "[wanted]");
+    CHECK(helper.Starts() == 1);
+}
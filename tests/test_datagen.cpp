@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include "datagen.hpp"
+#include "RowTable.hpp"
+#include "columns.hpp"
+
+#include <cmath>
+#include <memory>
+
+static std::string Generate(const DataGenOptions& options)
+{
+    std::string out;
+    DataGenerator generator(options);
+    while (generator.AppendNext(out)) out += '\n';
+    return out;
+}
+
+TEST_CASE("ParseCount accepts k/m/g suffixes", "[datagen]") {
+    CHECK(ParseCount("0") == 0u);
+    CHECK(ParseCount("250") == 250u);
+    CHECK(ParseCount("10k") == 10'000u);
+    CHECK(ParseCount("3M") == 3'000'000u);
+    CHECK(ParseCount("2g") == 2'000'000'000u);
+
+    CHECK_FALSE(ParseCount(""));
+    CHECK_FALSE(ParseCount("k"));
+    CHECK_FALSE(ParseCount("1.5m"));
+    CHECK_FALSE(ParseCount("-1"));
+    CHECK_FALSE(ParseCount("10x"));
+}
+
+TEST_CASE("DataShape names round-trip", "[datagen]") {
+    for (DataShape shape : {DataShape::Paths, DataShape::Vimgrep, DataShape::Table, DataShape::Log, DataShape::Unicode}) {
+        CHECK(ParseDataShape(DataShapeName(shape)) == shape);
+    }
+    CHECK_FALSE(ParseDataShape("csv"));
+}
+
+TEST_CASE("DataGenerator is deterministic", "[datagen]") {
+    for (DataShape shape : {DataShape::Paths, DataShape::Vimgrep, DataShape::Table, DataShape::Log, DataShape::Unicode}) {
+        DataGenOptions options{.shape = shape, .rows = 500, .seed = 7};
+        const std::string first = Generate(options);
+
+        CHECK(first == Generate(options));
+        CHECK(std::ranges::count(first, '\n') == 500);
+
+        options.seed = 8;
+        CHECK(first != Generate(options));
+    }
+}
+
+TEST_CASE("DataGenerator row shapes", "[datagen]") {
+    auto fieldCount = [](std::string_view line) { return std::ranges::count(line, '|') + 1; };
+
+    SECTION("vimgrep rows have four fields with numeric line and column") {
+        RowTable table;
+        DataGenerator generator({.shape = DataShape::Vimgrep, .rows = 200});
+        for (std::string line; generator.AppendNext(line); line.clear()) {
+            CHECK(fieldCount(line) == 4);
+            table.AddLine(line, '|');
+        }
+
+        ColumnCache columns;
+        for (double value : columns.Numeric(table, 1).values) CHECK_FALSE(std::isnan(value));
+        for (double value : columns.Numeric(table, 2).values) CHECK_FALSE(std::isnan(value));
+    }
+
+    SECTION("table rows have the requested number of columns") {
+        DataGenerator generator({.shape = DataShape::Table, .rows = 100, .columns = 30});
+        for (std::string line; generator.AppendNext(line); line.clear()) {
+            CHECK(fieldCount(line) == 30);
+        }
+    }
+
+    SECTION("unicode rows contain multi-byte text") {
+        const std::string text = Generate({.shape = DataShape::Unicode, .rows = 100});
+        CHECK(std::ranges::any_of(text, [](unsigned char c) { return c >= 0x80; }));
+    }
+
+    SECTION("generator stops after the requested rows") {
+        DataGenerator generator({.shape = DataShape::Paths, .rows = 3});
+        std::string line;
+        CHECK(generator.AppendNext(line));
+        CHECK(generator.AppendNext(line));
+        CHECK(generator.AppendNext(line));
+        CHECK_FALSE(generator.AppendNext(line));
+        CHECK(generator.Produced() == 3);
+    }
+}
+
+TEST_CASE("WriteDataset streams the generator's rows", "[datagen]") {
+    const DataGenOptions options{.shape = DataShape::Log, .rows = 5000, .seed = 3};
+
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file(std::tmpfile(), std::fclose);
+    REQUIRE(file);
+    REQUIRE(WriteDataset(options, file.get()));
+
+    std::rewind(file.get());
+    std::string written;
+    char buffer[4096];
+    for (size_t n; (n = std::fread(buffer, 1, sizeof buffer, file.get())) > 0;) {
+        written.append(buffer, n);
+    }
+    CHECK(written == Generate(options));
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include "dirlist.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+
+static const std::string testDir = "/tmp/fxf_test_dirlist";
+
+static void MakeTree(size_t files)
+{
+    std::filesystem::remove_all(testDir);
+    std::filesystem::create_directories(testDir);
+    for (size_t i = 0; i < files; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof name, "f%03zu", i);
+        std::ofstream(testDir + "/" + name) << std::string(i, 'x');
+    }
+}
+
+TEST_CASE("ListDirectory keeps the first entries by name", "[dirlist]") {
+    MakeTree(200);
+    std::filesystem::create_directory(testDir + "/a_dir");
+    std::filesystem::create_symlink("f001", testDir + "/b_link");
+
+    auto listing = ListDirectory(testDir, 5);
+    REQUIRE(listing.has_value());
+    CHECK(listing->total == 202);
+    CHECK_FALSE(listing->capped);
+    REQUIRE(listing->entries.size() == 5);
+    CHECK(listing->entries[0].name == "a_dir");
+    CHECK(listing->entries[1].name == "b_link");
+    CHECK(listing->entries[2].name == "f000");
+    CHECK(listing->entries[4].name == "f002");
+
+    CHECK(S_ISDIR(listing->entries[0].mode));
+    CHECK(S_ISLNK(listing->entries[1].mode));
+    CHECK(listing->entries[1].target == "f001");
+    CHECK(S_ISREG(listing->entries[4].mode));
+    CHECK(listing->entries[4].size == 2);
+
+    std::string text = FormatListing(*listing);
+    CHECK(text.find("b_link -> f001\n") != std::string::npos);
+    CHECK(text.find("\n... and 197 more entries\n") != std::string::npos);
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("ListDirectory stops counting at the cap", "[dirlist]") {
+    MakeTree(50);
+
+    auto listing = ListDirectory(testDir, 3, 20);
+    REQUIRE(listing.has_value());
+    CHECK(listing->total == 20);
+    CHECK(listing->capped);
+    CHECK(listing->entries.size() == 3);
+    CHECK(FormatListing(*listing).find("... and over 17 more entries") != std::string::npos);
+
+    // Exactly at the cap is still an exact count
+    listing = ListDirectory(testDir, 3, 50);
+    REQUIRE(listing.has_value());
+    CHECK(listing->total == 50);
+    CHECK_FALSE(listing->capped);
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("ListDirectory handles empty and missing directories", "[dirlist]") {
+    MakeTree(0);
+    auto listing = ListDirectory(testDir, 10);
+    REQUIRE(listing.has_value());
+    CHECK(listing->total == 0);
+    CHECK(FormatListing(*listing) == "(empty directory)\n");
+
+    CHECK_FALSE(ListDirectory(testDir + "/missing", 10).has_value());
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("FormatMode matches ls", "[dirlist]") {
+    CHECK(FormatMode(S_IFDIR | 0755) == "drwxr-xr-x");
+    CHECK(FormatMode(S_IFREG | 0644) == "-rw-r--r--");
+    CHECK(FormatMode(S_IFLNK | 0777) == "lrwxrwxrwx");
+    CHECK(FormatMode(S_IFREG | S_ISUID | 0755) == "-rwsr-xr-x");
+    CHECK(FormatMode(S_IFDIR | S_ISVTX | 0777) == "drwxrwxrwt");
+    CHECK(FormatMode(S_IFREG | S_ISGID | 0640) == "-rw-r-S---");
+}
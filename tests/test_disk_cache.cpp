@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include "disk_cache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+static const std::string testDir = "/tmp/fxf_test_disk_cache";
+
+static std::unique_ptr<DiskCache> OpenCache(uint64_t capacity = DiskCache::kDefaultCapacity)
+{
+    auto cache = DiskCache::Open(testDir, capacity);
+    REQUIRE(cache.has_value());
+    return std::move(*cache);
+}
+
+TEST_CASE("DiskCache stores values across sessions", "[preview][disk]") {
+    std::filesystem::remove_all(testDir);
+
+    {
+        auto cache = OpenCache();
+        CHECK_FALSE(cache->Lookup("a").has_value());
+        cache->Insert("a", "alpha");
+        cache->Insert("b", std::string("bin\0ary", 7));
+        cache->Insert("a", "ALPHA");
+        CHECK(cache->Lookup("a") == "ALPHA");
+        CHECK(cache->Entries() == 2);
+    }
+
+    auto cache = OpenCache();
+    CHECK(cache->Entries() == 2);
+    CHECK(cache->Lookup("a") == "ALPHA");
+    CHECK(cache->Lookup("b") == std::string("bin\0ary", 7));
+    CHECK_FALSE(cache->Lookup("c").has_value());
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("DiskCache recovers from damaged files", "[preview][disk]") {
+    std::filesystem::remove_all(testDir);
+    const std::string path = testDir + "/" + DiskCache::kFileName;
+
+    {
+        auto cache = OpenCache();
+        cache->Insert("kept", "value");
+        cache->Insert("torn", std::string(100, 'x'));
+    }
+
+    SECTION("a record cut short is dropped") {
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 10);
+        auto cache = OpenCache();
+        CHECK(cache->Lookup("kept") == "value");
+        CHECK_FALSE(cache->Lookup("torn").has_value());
+
+        // Appends line up again after the truncation
+        cache->Insert("new", "record");
+        auto reopened = OpenCache();
+        CHECK(reopened->Lookup("new") == "record");
+    }
+
+    SECTION("a corrupted value fails its checksum") {
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(-5, std::ios::end);
+            file.put('y');
+        }
+        auto cache = OpenCache();
+        CHECK(cache->Lookup("kept") == "value");
+        CHECK_FALSE(cache->Lookup("torn").has_value());
+        CHECK(cache->Entries() == 1);
+    }
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("DiskCache compacts to its most recently used records", "[preview][disk]") {
+    std::filesystem::remove_all(testDir);
+    const uint64_t capacity = 64 * 1024;
+    const std::string value(1000, 'v');
+
+    auto cache = OpenCache(capacity);
+    for (int i = 0; i < 60; ++i) {
+        cache->Insert("key" + std::to_string(i), value);
+    }
+    cache->Lookup("key0");      // Recently used, so it survives compaction
+
+    for (int i = 60; i < 70; ++i) {
+        cache->Insert("key" + std::to_string(i), value);
+    }
+    CHECK(cache->FileBytes() < capacity);
+    CHECK(cache->Lookup("key0") == value);
+    CHECK_FALSE(cache->Lookup("key1").has_value());
+    CHECK(cache->Lookup("key69") == value);
+
+    for (int i = 70; i < 200; ++i) {
+        cache->Insert("key" + std::to_string(i), value);
+        CHECK(cache->FileBytes() <= capacity);
+    }
+    CHECK(cache->Lookup("key199") == value);
+    CHECK(std::filesystem::file_size(testDir + "/" + DiskCache::kFileName) == cache->FileBytes());
+
+    auto reopened = OpenCache(capacity);
+    CHECK(reopened->Entries() == cache->Entries());
+    CHECK(reopened->Lookup("key199") == value);
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("DiskCache picks up a store compacted by another session", "[preview][disk]") {
+    std::filesystem::remove_all(testDir);
+
+    auto first = OpenCache();
+    first->Insert("shared", "one");
+
+    {
+        auto second = OpenCache(2048);
+        second->Insert("big", std::string(1500, 'b'));    // Compacts into a new file
+    }
+
+    first->Insert("after", "two");
+    auto reopened = OpenCache();
+    CHECK(reopened->Lookup("after") == "two");
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("DiskCache reports an unusable directory", "[preview][disk]") {
+    auto cache = DiskCache::Open("/proc/fxf-cannot-create");
+    REQUIRE_FALSE(cache.has_value());
+    CHECK(cache.error().find("preview cache") != std::string::npos);
+}
@@ -0,0 +1,170 @@
+#include <catch2/catch_test_macros.hpp>
+#include "fileview.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static void WriteFile(const std::string& path, const std::string& content)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << content;
+}
+
+TEST_CASE("LooksBinary sniffs NUL bytes and invalid UTF-8", "[fileview]") {
+    CHECK_FALSE(LooksBinary("", false));
+    CHECK_FALSE(LooksBinary("int main() {}\n", false));
+    CHECK_FALSE(LooksBinary("naïve 日本語\n", false));
+    CHECK(LooksBinary(std::string("ab\0cd", 5), false));
+    CHECK(LooksBinary("latin-1 caf\xe9 au lait", false));
+
+    SECTION("a sequence cut at the end only counts when the head is complete") {
+        CHECK(LooksBinary("text \xe6\x97", false));
+        CHECK_FALSE(LooksBinary("text \xe6\x97", true));
+    }
+}
+
+TEST_CASE("ReadFileLines extracts a line window", "[fileview]") {
+    std::string testFile = "/tmp/fxf_test_fileview.txt";
+    std::string content;
+    for (int i = 1; i <= 100'000; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    WriteFile(testFile, content);
+
+    SECTION("head of the file") {
+        auto excerpt = ReadFileLines(testFile, 1, 3);
+        REQUIRE(excerpt.has_value());
+        CHECK_FALSE(excerpt->binary);
+        CHECK(excerpt->text == "line 1\nline 2\nline 3\n");
+    }
+
+    SECTION("window deep in the file, across read blocks") {
+        auto excerpt = ReadFileLines(testFile, 90'000, 2);
+        REQUIRE(excerpt.has_value());
+        CHECK(excerpt->text == "line 90000\nline 90001\n");
+    }
+
+    SECTION("window running past the end") {
+        auto excerpt = ReadFileLines(testFile, 99'999, 10);
+        REQUIRE(excerpt.has_value());
+        CHECK(excerpt->text == "line 99999\nline 100000\n");
+    }
+
+    SECTION("window past the end is empty") {
+        auto excerpt = ReadFileLines(testFile, 200'000, 10);
+        REQUIRE(excerpt.has_value());
+        CHECK(excerpt->text.empty());
+    }
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("ReadFileLines edge cases", "[fileview]") {
+    std::string testFile = "/tmp/fxf_test_fileview.txt";
+
+    SECTION("last line without a newline") {
+        WriteFile(testFile, "a\nb");
+        auto excerpt = ReadFileLines(testFile, 2, 5);
+        REQUIRE(excerpt.has_value());
+        CHECK(excerpt->text == "b");
+    }
+
+    SECTION("empty file is text") {
+        WriteFile(testFile, "");
+        auto excerpt = ReadFileLines(testFile, 1, 50);
+        REQUIRE(excerpt.has_value());
+        CHECK_FALSE(excerpt->binary);
+        CHECK(excerpt->text.empty());
+    }
+
+    SECTION("binary file") {
+        WriteFile(testFile, std::string("\x7f" "ELF\2\1\1\0\0\0", 10));
+        auto excerpt = ReadFileLines(testFile, 1, 50);
+        REQUIRE(excerpt.has_value());
+        CHECK(excerpt->binary);
+        CHECK(excerpt->text.empty());
+    }
+
+    SECTION("nonexistent file returns error") {
+        auto excerpt = ReadFileLines("/nonexistent/path/file.txt", 1, 50);
+        REQUIRE_FALSE(excerpt.has_value());
+        CHECK(excerpt.error().find("Failed to open") != std::string::npos);
+    }
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("CountNewlines counts across vector and scalar tails", "[fileview]") {
+    CHECK(CountNewlines("", 0) == 0);
+    for (size_t size : {1u, 15u, 16u, 17u, 100u}) {
+        std::string text(size, 'x');
+        for (size_t i = 0; i < size; i += 3) text[i] = '\n';
+        CHECK(CountNewlines(text.data(), text.size()) == (size + 2) / 3);
+    }
+}
+
+TEST_CASE("LineIndex jumps to deep lines", "[fileview]") {
+    std::string testFile = "/tmp/fxf_test_fileview.txt";
+    std::string content;
+    for (int i = 1; i <= 300'000; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    WriteFile(testFile, content);
+
+    SECTION("indexed windows match a plain scan") {
+        LineIndexCache indexes;
+        for (size_t first : {1u, 1024u, 1025u, 2049u, 123'456u, 299'995u}) {
+            auto indexed = ReadFileLines(testFile, first, 21, &indexes);
+            auto scanned = ReadFileLines(testFile, first, 21);
+            REQUIRE(indexed.has_value());
+            REQUIRE(scanned.has_value());
+            CHECK(indexed->text == scanned->text);
+        }
+        CHECK(ReadFileLines(testFile, 250'000, 1, &indexes)->text == "line 250000\n");
+        CHECK(indexes.Size() == 1);
+    }
+
+    SECTION("the index is only extended as far as needed") {
+        LineIndexCache indexes;
+        ReadFileLines(testFile, 5000, 1, &indexes);
+        auto index = indexes.Get(testFile, {});
+        CHECK(index->Checkpoints() == 1);   // Stamp differs, so a fresh index
+
+        LineIndex direct({});
+        int fd = ::open(testFile.c_str(), O_RDONLY);
+        REQUIRE(fd >= 0);
+        auto checkpoint = direct.Seek(fd, 5000);
+        REQUIRE(checkpoint.has_value());
+        CHECK(checkpoint->line == 4 * LineIndex::kStride + 1);
+        CHECK(content.compare(checkpoint->offset, 10, "line 4097\n") == 0);
+        CHECK(direct.Checkpoints() < 300'000 / LineIndex::kStride);
+
+        // Past the end the last checkpoint is returned
+        checkpoint = direct.Seek(fd, 10'000'000);
+        REQUIRE(checkpoint.has_value());
+        CHECK(checkpoint->line == 292 * LineIndex::kStride + 1);
+        ::close(fd);
+    }
+
+    SECTION("a changed file gets a new index") {
+        LineIndexCache indexes;
+        auto first = indexes.Get(testFile, {.size = 10, .mtimeNs = 1});
+        CHECK(indexes.Get(testFile, {.size = 10, .mtimeNs = 1}) == first);
+        CHECK(indexes.Get(testFile, {.size = 10, .mtimeNs = 2}) != first);
+        CHECK(indexes.Size() == 1);
+    }
+
+    SECTION("least recently used files are evicted") {
+        LineIndexCache indexes;
+        for (size_t i = 0; i <= LineIndexCache::kMaxFiles; ++i) {
+            indexes.Get("/file" + std::to_string(i), {});
+        }
+        CHECK(indexes.Size() == LineIndexCache::kMaxFiles);
+    }
+
+    std::filesystem::remove(testFile);
+}
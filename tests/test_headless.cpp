@@ -0,0 +1,52 @@
+#include <catch2/catch_test_macros.hpp>
+#include "headless.hpp"
+
+#include <cstdio>
+#include <memory>
+
+// Runs RunHeadless into a temporary file and returns what it wrote.
+static std::pair<int, std::string> Run(const RowTable& lines, HeadlessOptions options)
+{
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file(std::tmpfile(), std::fclose);
+    REQUIRE(file);
+    int rc = RunHeadless(lines, options, file.get());
+
+    std::rewind(file.get());
+    std::string output;
+    char buffer[4096];
+    for (size_t n; (n = std::fread(buffer, 1, sizeof buffer, file.get())) > 0;) {
+        output.append(buffer, n);
+    }
+    return {rc, output};
+}
+
+TEST_CASE("RunHeadless streams ranked matches", "[headless]") {
+    RowTable lines;
+    lines.AddLine("apple|red", '|');
+    lines.AddLine("banana|yellow", '|');
+    lines.AddLine("cherry|red", '|');
+
+    SECTION("empty query prints every row through the view template") {
+        auto [rc, output] = Run(lines, {.query = "", .viewTemplate = "{1}:{0}"});
+        CHECK(rc == 0);
+        CHECK(output == "red:apple\nyellow:banana\nred:cherry\n");
+    }
+
+    SECTION("query ranks the best match first") {
+        auto [rc, output] = Run(lines, {.query = "banana"});
+        CHECK(rc == 0);
+        CHECK(output.starts_with("banana | yellow\n"));
+    }
+
+    SECTION("matching uses the rendered view") {
+        auto [rc, output] = Run(lines, {.query = "yellow", .viewTemplate = "{0}"});
+        CHECK(rc == 1);
+        CHECK(output.empty());
+    }
+
+    SECTION("no match exits with 1") {
+        auto [rc, output] = Run(lines, {.query = "zzzzzz"});
+        CHECK(rc == 1);
+        CHECK(output.empty());
+    }
+}
@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+#include "memory.hpp"
+#include "alloc_hook.hpp"
+#include "bitset.hpp"
+#include "columns.hpp"
+#include "template.hpp"
+
+#include <new>
+
+TEST_CASE("HeapBytes counts reserved storage", "[memory]") {
+    SECTION("short strings live inline") {
+        CHECK(HeapBytes(std::string("abc")) == 0);
+        std::string large(1000, 'x');
+        CHECK(HeapBytes(large) >= 1000);
+    }
+
+    SECTION("vectors count capacity, not size") {
+        std::vector<size_t> indices;
+        indices.reserve(100);
+        indices.push_back(1);
+        CHECK(HeapBytes(indices) == 100 * sizeof(size_t));
+    }
+
+    SECTION("row tables count rows, fields and field text") {
+        RowTable table;
+        table.AddLine("a|b|c", '|');
+        table.AddLine(std::string(200, 'x') + "|y", '|');
+
+        CHECK(FieldCount(table) == 5);
+        size_t minimum = 2 * sizeof(RowTable::row_t) + 5 * sizeof(std::string) + 200;
+        CHECK(HeapBytes(table) >= minimum);
+    }
+}
+
+TEST_CASE("FormatMemoryReport lists every entry and a total", "[memory]") {
+    std::vector<MemoryEntry> entries = {
+        {"rows", 4, 4096},
+        {"selections", 0, 0},
+    };
+    std::string report = FormatMemoryReport(entries);
+
+    CHECK(report.find("rows") != std::string::npos);
+    CHECK(report.find("4.0 KiB") != std::string::npos);
+    CHECK(report.find("1.0 KiB") != std::string::npos);   // Average per row
+    CHECK(report.find("selections") != std::string::npos);
+    CHECK(report.find("total") != std::string::npos);
+
+    CHECK(FormatBytes(512) == "512 B");
+    CHECK(FormatBytes(3 * 1024 * 1024 / 2) == "1.5 MiB");
+}
+
+TEST_CASE("Allocation budgets of hot operations", "[memory][alloc]") {
+    SECTION("rendering into a reserved buffer does not allocate") {
+        const CompiledTemplate compiled("{0} - {2} ({})");
+        const std::vector<std::string> row = {"first field", "second field", "third field"};
+        std::string out;
+        out.reserve(256);
+
+        AllocationCounter counter;
+        for (int i = 0; i < 100; ++i) {
+            out.clear();
+            compiled.RenderInto(out, row);
+        }
+        CHECK(counter.Count() == 0);
+    }
+
+    SECTION("cached numeric columns are reused") {
+        RowTable table;
+        for (int i = 0; i < 1000; ++i) table.AddLine("row|" + std::to_string(i), '|');
+        ColumnCache columns;
+        columns.Numeric(table, 1);
+
+        AllocationCounter counter;
+        const auto& values = columns.Numeric(table, 1).values;
+        CHECK(counter.Count() == 0);
+        CHECK(values[999] == 999);
+    }
+
+    SECTION("selection bits within the table do not allocate") {
+        DynamicBitset selections;
+        selections.Resize(10'000);
+
+        AllocationCounter counter;
+        for (size_t i = 0; i < 10'000; i += 3) selections.Flip(i);
+        selections.FlipAll();
+        CHECK(selections.Count() > 0);
+        CHECK(counter.Count() == 0);
+    }
+}
+
+TEST_CASE("AllocationCounter sees every form of operator new", "[memory][alloc]") {
+    struct alignas(64) Aligned {
+        char bytes[64];
+    };
+
+    // Stored through a volatile so the optimizer cannot elide new/delete pairs
+    [[maybe_unused]] static void* volatile escaped;
+    auto keep = [](auto* ptr) {
+        escaped = ptr;
+        return ptr;
+    };
+
+    AllocationCounter counter;
+    delete keep(new int(1));
+    delete[] keep(new int[4]);
+    delete keep(new (std::nothrow) int(2));
+    delete[] keep(new (std::nothrow) int[4]);
+    auto* aligned = keep(new Aligned);
+    CHECK(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+    delete aligned;
+    delete[] keep(new Aligned[3]);
+    delete keep(new (std::nothrow) Aligned);
+
+    AllocStats delta = counter.Delta();
+    CHECK(delta.count == 7);
+    CHECK(delta.bytes >= 4 + 16 + 4 + 16 + 64 + 192 + 64);
+}
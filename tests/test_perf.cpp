@@ -0,0 +1,71 @@
+#include <catch2/catch_test_macros.hpp>
+#include "perf.hpp"
+
+TEST_CASE("LatencyHistogram buckets", "[perf]") {
+    SECTION("every value lands in a bucket whose bound covers it within 25%") {
+        const uint64_t values[] = {0, 1, 3, 4, 5, 7, 8, 100, 999, 1'000'000, 123'456'789, uint64_t{1} << 62, UINT64_MAX};
+        for (uint64_t ns : values) {
+            size_t index = LatencyHistogram::BucketIndex(ns);
+            REQUIRE(index < LatencyHistogram::kBucketCount);
+            uint64_t bound = LatencyHistogram::BucketUpperBound(index);
+            CHECK(bound >= ns);
+            CHECK(bound - ns <= ns / 4 + 1);
+        }
+    }
+
+    SECTION("bucket indices are monotonic") {
+        size_t previous = 0;
+        for (uint64_t ns = 0; ns < 100'000; ns += 7) {
+            size_t index = LatencyHistogram::BucketIndex(ns);
+            CHECK(index >= previous);
+            previous = index;
+        }
+    }
+}
+
+TEST_CASE("LatencyHistogram percentiles", "[perf]") {
+    LatencyHistogram histogram;
+    CHECK(histogram.Percentile(99) == 0);
+
+    for (int i = 0; i < 99; ++i) histogram.Record(1'000);
+    histogram.Record(1'000'000);
+
+    CHECK(histogram.Count() == 100);
+    CHECK(histogram.Last() == 1'000'000);
+    CHECK(histogram.Max() == 1'000'000);
+
+    uint64_t p50 = histogram.Percentile(50);
+    CHECK(p50 >= 1'000);
+    CHECK(p50 < 1'250);
+    CHECK(histogram.Percentile(99) < 1'250);
+    CHECK(histogram.Percentile(100) == 1'000'000);
+
+    histogram.Reset();
+    CHECK(histogram.Count() == 0);
+    CHECK(histogram.Percentile(50) == 0);
+}
+
+TEST_CASE("ScopedTimer records only when enabled", "[perf]") {
+    Perf::Reset();
+
+    Perf::SetEnabled(false);
+    { ScopedTimer timer(PerfStage::Sort); }
+    CHECK(Perf::Histogram(PerfStage::Sort).Count() == 0);
+    CHECK(Perf::Summary() == "no samples");
+
+    Perf::SetEnabled(true);
+    { ScopedTimer timer(PerfStage::Sort); }
+    Perf::SetEnabled(false);
+    CHECK(Perf::Histogram(PerfStage::Sort).Count() == 1);
+    CHECK(Perf::Summary().starts_with("sort "));
+
+    Perf::Reset();
+}
+
+TEST_CASE("FormatDuration picks a readable unit", "[perf]") {
+    CHECK(FormatDuration(850) == "850ns");
+    CHECK(FormatDuration(12'300) == "12us");
+    CHECK(FormatDuration(3'400'000) == "3.4ms");
+    CHECK(FormatDuration(45'000'000) == "45ms");
+    CHECK(FormatDuration(1'250'000'000) == "1.25s");
+}
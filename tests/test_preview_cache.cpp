@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+#include "preview_cache.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("PreviewCache stores and finds values", "[preview][cache]") {
+    PreviewCache cache;
+    CHECK(cache.Lookup("missing") == nullptr);
+
+    cache.Insert("a.txt", "alpha");
+    cache.Insert("b.txt", "beta");
+    REQUIRE(cache.Lookup("a.txt") != nullptr);
+    CHECK(*cache.Lookup("a.txt") == "alpha");
+    CHECK(cache.Entries() == 2);
+    CHECK(cache.Bytes() == PreviewCache::Charge("a.txt", "alpha") + PreviewCache::Charge("b.txt", "beta"));
+
+    SECTION("insert replaces an existing value") {
+        cache.Insert("a.txt", "ALPHA");
+        CHECK(*cache.Lookup("a.txt") == "ALPHA");
+        CHECK(cache.Entries() == 2);
+    }
+
+    SECTION("clear drops everything") {
+        cache.Clear();
+        CHECK(cache.Lookup("a.txt") == nullptr);
+        CHECK(cache.Entries() == 0);
+        CHECK(cache.Bytes() == 0);
+    }
+
+    SECTION("values outlive their eviction") {
+        PreviewCache::Value held = cache.Lookup("b.txt");
+        cache.Clear();
+        CHECK(*held == "beta");
+    }
+}
+
+TEST_CASE("PreviewCache evicts by bytes, least recently used first", "[preview][cache]") {
+    // Keys that land in one shard, whose share of the budget fits three entries.
+    const std::string value(1000, 'x');
+    const size_t charge = PreviewCache::Charge("key-00", value);
+    PreviewCache cache(PreviewCache::kShards * 3 * charge);
+
+    std::vector<std::string> keys;
+    for (int i = 0; keys.size() < 4; ++i) {
+        std::string key = "key-" + std::to_string(10 + i);
+        if (PreviewCache::ShardIndex(key) == PreviewCache::ShardIndex("key-10")) keys.push_back(key);
+    }
+
+    cache.Insert(keys[0], value);
+    cache.Insert(keys[1], value);
+    cache.Insert(keys[2], value);
+    cache.Lookup(keys[0]);            // keys[1] is now the least recently used
+    cache.Insert(keys[3], value);
+
+    CHECK(cache.Lookup(keys[0]) != nullptr);
+    CHECK(cache.Lookup(keys[1]) == nullptr);
+    CHECK(cache.Lookup(keys[2]) != nullptr);
+    CHECK(cache.Lookup(keys[3]) != nullptr);
+    CHECK(cache.Bytes() == 3 * charge);
+}
+
+TEST_CASE("PreviewCache respects its budget", "[preview][cache]") {
+    PreviewCache cache(PreviewCache::kShards * 4096);
+
+    SECTION("a value larger than a shard's share is not cached") {
+        cache.Insert("huge", std::string(8192, 'x'));
+        CHECK(cache.Lookup("huge") == nullptr);
+        CHECK(cache.Bytes() == 0);
+    }
+
+    SECTION("total bytes stay within budget") {
+        for (int i = 0; i < 1000; ++i) {
+            cache.Insert("file" + std::to_string(i), std::string(100 + i % 500, 'x'));
+            CHECK(cache.Bytes() <= cache.Budget());
+        }
+        CHECK(cache.Entries() > 0);
+    }
+
+    SECTION("shrinking the budget evicts immediately") {
+        for (int i = 0; i < 100; ++i) {
+            cache.Insert("file" + std::to_string(i), std::string(200, 'x'));
+        }
+        cache.SetBudget(0);
+        CHECK(cache.Entries() == 0);
+        CHECK(cache.Bytes() == 0);
+    }
+}
+
+// Meant to be run under ThreadSanitizer (-DFXF_TSAN=ON) as well.
+TEST_CASE("PreviewCache is safe to hammer from many threads", "[preview][cache][threads]") {
+    PreviewCache cache(PreviewCache::kShards * 16 * 1024);
+    constexpr int kThreads = 8;
+    constexpr int kOps = 20'000;
+
+    std::atomic<int> torn{0};
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&cache, &torn, t] {
+                for (int i = 0; i < kOps; ++i) {
+                    std::string key = "row" + std::to_string((i * 7 + t) % 500);
+                    if (i % 3 == 0) {
+                        cache.Insert(key, std::string(64 + i % 256, 'a' + t));
+                    } else if (auto value = cache.Lookup(key)) {
+                        // Values are immutable once shared
+                        if (value->size() < 64 || value->front() != value->back()) ++torn;
+                    }
+                    if (i % 5000 == 0) cache.Bytes();
+                    if (t == 0 && i == kOps / 2) cache.Clear();
+                }
+            });
+        }
+    }
+
+    CHECK(torn == 0);
+    CHECK(cache.Bytes() <= cache.Budget());
+}
@@ -0,0 +1,203 @@
+#include <catch2/catch_test_macros.hpp>
+#include "preview_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("PreviewPool runs submitted jobs", "[preview]") {
+    PreviewPool pool(2);
+    std::atomic<int> runs{0};
+    pool.Submit([&](std::stop_token) { ++runs; });
+    pool.WaitIdle();
+
+    CHECK(runs == 1);
+    CHECK(pool.Stats().submitted == 1);
+    CHECK(pool.Stats().completed == 1);
+    CHECK(pool.Stats().wasted == 0);
+}
+
+TEST_CASE("PreviewPool lets the latest request win", "[preview][threads]") {
+    PreviewPool pool(1);
+
+    // Occupy the only worker until it is asked to stop and every submit below
+    // has been made, so none of them can start early.
+    std::latch started(1);
+    std::latch release(1);
+    std::atomic<bool> sawStop{false};
+    pool.Submit([&](std::stop_token stop) {
+        started.count_down();
+        while (!stop.stop_requested()) std::this_thread::sleep_for(1ms);
+        sawStop = true;
+        release.wait();
+    });
+    started.wait();
+
+    // Only the last of these may run; the others are replaced while queued.
+    std::atomic<int> lastRun{-1};
+    std::atomic<int> runs{0};
+    for (int i = 0; i < 10; ++i) {
+        pool.Submit([&, i](std::stop_token) { ++runs; lastRun = i; });
+    }
+    release.count_down();
+    pool.WaitIdle();
+
+    CHECK(sawStop);
+    CHECK(runs == 1);
+    CHECK(lastRun == 9);
+
+    PreviewPoolStats stats = pool.Stats();
+    CHECK(stats.submitted == 11);
+    CHECK(stats.superseded == 9);
+    CHECK(stats.wasted == 1);
+    CHECK(stats.wastedNs > 0);
+    CHECK(stats.completed == 1);
+}
+
+TEST_CASE("PreviewPool Cancel stops running and queued jobs", "[preview][threads]") {
+    PreviewPool pool(1);
+
+    // The busy job is stopped by the second Submit, but holds the worker until
+    // Cancel() has run, so the queued job cannot start first.
+    std::latch started(1);
+    std::latch release(1);
+    pool.Submit([&](std::stop_token stop) {
+        started.count_down();
+        while (!stop.stop_requested()) std::this_thread::sleep_for(1ms);
+        release.wait();
+    });
+    started.wait();
+
+    std::atomic<bool> queuedRan{false};
+    pool.Submit([&](std::stop_token) { queuedRan = true; });
+    pool.Cancel();
+    release.count_down();
+    pool.WaitIdle();
+
+    CHECK_FALSE(queuedRan);
+    CHECK(pool.Stats().wasted == 1);
+    CHECK(pool.Stats().completed == 0);
+}
+
+TEST_CASE("PreviewPool joins busy workers on destruction", "[preview]") {
+    std::atomic<bool> stopped{false};
+    {
+        PreviewPool pool(2);
+        std::latch started(1);
+        pool.Submit([&](std::stop_token stop) {
+            started.count_down();
+            while (!stop.stop_requested()) std::this_thread::sleep_for(1ms);
+            stopped = true;
+        });
+        started.wait();
+    }
+    CHECK(stopped);
+}
+
+TEST_CASE("PreviewPool runs prefetches after requests", "[preview][threads]") {
+    PreviewPool pool(1);
+
+    // Hold the worker so the queue fills up; a request stops it.
+    std::latch started(1);
+    pool.Submit([&](std::stop_token stop) {
+        started.count_down();
+        while (!stop.stop_requested()) std::this_thread::sleep_for(1ms);
+    });
+    started.wait();
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&](std::string name) {
+        return [&, name](std::stop_token) {
+            std::lock_guard lock(mutex);
+            order.push_back(name);
+        };
+    };
+
+    pool.Prefetch({record("stale")});
+    pool.Prefetch({record("next"), record("after next")});
+    pool.Submit(record("request"));
+    pool.WaitIdle();
+
+    CHECK(order == std::vector<std::string>{"request", "next", "after next"});
+    PreviewPoolStats stats = pool.Stats();
+    CHECK(stats.completed == 1);
+    CHECK(stats.prefetched == 2);
+    CHECK(stats.superseded == 1);
+    CHECK(stats.wasted == 1);
+}
+
+TEST_CASE("PreviewPool does not waste prefetches queued after a request", "[preview][threads]") {
+    // The order App::UpdatePreview uses on a j/k step, with every worker idle:
+    // the request goes in first, so no worker starts a prefetch that the
+    // request then has to stop.
+    PreviewPool pool(2);
+    std::atomic<bool> requested{false};
+    std::atomic<int> prefetched{0};
+    auto render = [](std::stop_token stop) {
+        for (int i = 0; i < 20 && !stop.stop_requested(); ++i) std::this_thread::sleep_for(1ms);
+    };
+
+    for (int step = 0; step < 5; ++step) {
+        pool.Submit([&](std::stop_token stop) { render(stop); requested = true; });
+        pool.Prefetch({
+            [&](std::stop_token stop) { render(stop); ++prefetched; },
+            [&](std::stop_token stop) { render(stop); ++prefetched; },
+        });
+        pool.WaitIdle();
+    }
+
+    CHECK(requested);
+    CHECK(prefetched == 10);
+    PreviewPoolStats stats = pool.Stats();
+    CHECK(stats.completed == 5);
+    CHECK(stats.prefetched == 10);
+    CHECK(stats.wasted == 0);
+}
+
+TEST_CASE("PreviewPool cancels prefetches on a jump", "[preview][threads]") {
+    PreviewPool pool(1);
+    std::latch started(1);
+    std::atomic<bool> stopped{false};
+    std::atomic<int> later{0};
+    pool.Prefetch({
+        [&](std::stop_token stop) {
+            started.count_down();
+            while (!stop.stop_requested()) std::this_thread::sleep_for(1ms);
+            stopped = true;
+        },
+        [&](std::stop_token) { ++later; },
+    });
+    started.wait();
+
+    pool.CancelPrefetch();
+    pool.WaitIdle();
+
+    CHECK(stopped);
+    CHECK(later == 0);
+    CHECK(pool.Stats().superseded == 1);
+    CHECK(pool.Stats().wasted == 1);
+}
+
+TEST_CASE("PreviewPool makes room for a request when prefetches hold every worker", "[preview][threads]") {
+    PreviewPool pool(2);
+    std::latch started(2);
+    auto hog = [&](std::stop_token stop) {
+        started.count_down();
+        while (!stop.stop_requested()) std::this_thread::sleep_for(1ms);
+    };
+    pool.Prefetch({hog, hog});
+    started.wait();
+
+    std::atomic<bool> ran{false};
+    pool.Submit([&](std::stop_token) { ran = true; });
+    pool.WaitIdle();
+
+    CHECK(ran);
+    CHECK(pool.Stats().wasted == 2);
+}
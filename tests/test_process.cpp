@@ -0,0 +1,150 @@
+#include <catch2/catch_test_macros.hpp>
+#include "process.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("RunShell captures stdout and the exit code", "[process]") {
+    auto result = RunShell("printf 'one\\ntwo\\n'; exit 3");
+    REQUIRE(result);
+    CHECK(result->output == "one\ntwo\n");
+    CHECK(result->exitCode == 3);
+    CHECK(result->signal == 0);
+    CHECK_FALSE(result->stopped);
+    CHECK_FALSE(result->timedOut);
+    CHECK_FALSE(result->truncated);
+}
+
+TEST_CASE("RunShell reads large output whole", "[process]") {
+    auto result = RunShell("head -c 5000000 /dev/zero | tr '\\0' x");
+    REQUIRE(result);
+    CHECK(result->exitCode == 0);
+    CHECK(result->output.size() == 5000000);
+    CHECK(result->output.find_first_not_of('x') == std::string::npos);
+}
+
+TEST_CASE("RunShell can discard stderr", "[process]") {
+    auto result = RunShell("echo out; echo err >&2", {.discardStderr = true});
+    REQUIRE(result);
+    CHECK(result->output == "out\n");
+}
+
+TEST_CASE("RunProcess passes arguments without a shell", "[process]") {
+    auto result = RunProcess({"printf", "%s|", "two words", "$HOME", "*"});
+    REQUIRE(result);
+    CHECK(result->output == "two words|$HOME|*|");
+    CHECK(result->exitCode == 0);
+
+    auto missing = RunProcess({"fxf-no-such-program"});
+    REQUIRE_FALSE(missing);
+    CHECK(missing.error().find("fxf-no-such-program") != std::string::npos);
+
+    CHECK_FALSE(RunProcess({}));
+}
+
+TEST_CASE("RunProcess without capture only reports the exit code", "[process]") {
+    auto ok = RunProcess({"true"}, {.captureOutput = false});
+    REQUIRE(ok);
+    CHECK(ok->exitCode == 0);
+    CHECK(ok->output.empty());
+
+    auto failed = RunProcess({"false"}, {.captureOutput = false});
+    REQUIRE(failed);
+    CHECK(failed->exitCode == 1);
+}
+
+TEST_CASE("RunShell kills the whole pipeline on a timeout", "[process]") {
+    auto start = std::chrono::steady_clock::now();
+    auto result = RunShell("echo partial; sleep 10 | cat", {.timeout = 100ms});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(result);
+    CHECK(result->timedOut);
+    CHECK(result->output == "partial\n");
+    CHECK(result->signal == SIGKILL);
+    CHECK(result->exitCode == -1);
+    CHECK(elapsed < 5s);
+}
+
+TEST_CASE("RunShell stops at maxOutput", "[process]") {
+    auto result = RunShell("yes", {.maxOutput = 100000});
+    REQUIRE(result);
+    CHECK(result->truncated);
+    CHECK(result->output.size() == 100000);
+    CHECK(result->output.starts_with("y\ny\n"));
+}
+
+TEST_CASE("RunShell streams output and stops when the sink declines", "[process]") {
+    std::string seen;
+    auto all = RunShell("echo a; sleep 0.05; echo b", {.onOutput = [&](std::string_view chunk) {
+        seen += chunk;
+        return true;
+    }});
+    REQUIRE(all);
+    CHECK(all->output == "a\nb\n");
+    CHECK(seen == all->output);
+
+    size_t calls = 0;
+    auto declined = RunShell("echo first; sleep 10", {.onOutput = [&](std::string_view) {
+        ++calls;
+        return false;
+    }});
+    REQUIRE(declined);
+    CHECK(declined->truncated);
+    CHECK(declined->output == "first\n");
+    CHECK(calls == 1);
+}
+
+TEST_CASE("RunShell kills the command on a stop request", "[process]") {
+    std::stop_source source;
+    std::jthread stopper([&] {
+        std::this_thread::sleep_for(50ms);
+        source.request_stop();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = RunShell("sleep 10 | cat", {.stop = source.get_token()});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(result);
+    CHECK(result->stopped);
+    CHECK(result->signal == SIGKILL);
+    CHECK(elapsed < 5s);
+}
+
+TEST_CASE("RunShell holds a command that closed its stdout to the timeout", "[process]") {
+    auto start = std::chrono::steady_clock::now();
+    auto result = RunShell("exec >/dev/null; sleep 10", {.timeout = 100ms});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(result);
+    CHECK(result->timedOut);
+    CHECK(result->signal == SIGKILL);
+    CHECK(elapsed < 5s);
+}
+
+TEST_CASE("RunShell can keep a command in fxf's process group", "[process]") {
+    auto own = RunShell("cut -d' ' -f5 /proc/$$/stat", {});
+    auto shared = RunShell("cut -d' ' -f5 /proc/$$/stat", {.newProcessGroup = false});
+    REQUIRE(own);
+    REQUIRE(shared);
+    CHECK(std::stoi(shared->output) == getpgrp());
+    CHECK(std::stoi(own->output) != getpgrp());
+
+    // Limits still apply, by killing the child alone
+    auto capped = RunShell("yes", {.newProcessGroup = false, .maxOutput = 1000});
+    REQUIRE(capped);
+    CHECK(capped->truncated);
+    CHECK(capped->output.size() == 1000);
+
+    auto timed = RunShell("exec sleep 10", {.newProcessGroup = false, .timeout = 100ms});
+    REQUIRE(timed);
+    CHECK(timed->timedOut);
+}
@@ -0,0 +1,246 @@
+#include <catch2/catch_test_macros.hpp>
+#include "query.hpp"
+#include "parallel.hpp"
+
+#include <numeric>
+#include <random>
+
+static RowTable MakeTable(std::initializer_list<const char*> lines)
+{
+    RowTable table;
+    for (const char* line : lines) table.AddLine(line, '|');
+    return table;
+}
+
+static std::vector<size_t> AllRows(const RowTable& table)
+{
+    std::vector<size_t> indices(table.data.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    return indices;
+}
+
+TEST_CASE("ParseNumber accepts whole numeric fields only", "[query]") {
+    double value = 0;
+    CHECK(ParseNumber("42", value));
+    CHECK(value == 42);
+    CHECK(ParseNumber(" -1.5 ", value));
+    CHECK(value == -1.5);
+    CHECK(ParseNumber("+3", value));
+    CHECK(value == 3);
+    CHECK_FALSE(ParseNumber("", value));
+    CHECK_FALSE(ParseNumber("12abc", value));
+    CHECK_FALSE(ParseNumber("nan", value));
+}
+
+TEST_CASE("ParseSortSpec", "[query]") {
+    SECTION("defaults to lexical ascending") {
+        auto spec = ParseSortSpec({"2"});
+        REQUIRE(spec);
+        CHECK(spec->column == 2);
+        CHECK(spec->key == SortSpec::Key::Lexical);
+        CHECK_FALSE(spec->descending);
+    }
+
+    SECTION("options in any order") {
+        auto spec = ParseSortSpec({"1", "desc", "numeric"});
+        REQUIRE(spec);
+        CHECK(spec->key == SortSpec::Key::Numeric);
+        CHECK(spec->descending);
+    }
+
+    SECTION("rejects bad input") {
+        CHECK_FALSE(ParseSortSpec({}));
+        CHECK_FALSE(ParseSortSpec({"x"}));
+        CHECK_FALSE(ParseSortSpec({"1", "sideways"}));
+    }
+}
+
+TEST_CASE("SortIndices orders a permutation without touching rows", "[query]") {
+    RowTable table = MakeTable({"b|10", "a|9", "c|x", "a|100"});
+    ColumnCache columns;
+    auto indices = AllRows(table);
+
+    SECTION("lexical ascending, ties by row") {
+        SortIndices(table, columns, indices, {0, SortSpec::Key::Lexical, false});
+        CHECK(indices == std::vector<size_t>{1, 3, 0, 2});
+        CHECK(table[0][0] == "b");
+    }
+
+    SECTION("lexical descending") {
+        SortIndices(table, columns, indices, {0, SortSpec::Key::Lexical, true});
+        CHECK(indices == std::vector<size_t>{2, 0, 1, 3});
+    }
+
+    SECTION("numeric, non-numbers last") {
+        SortIndices(table, columns, indices, {1, SortSpec::Key::Numeric, false});
+        CHECK(indices == std::vector<size_t>{1, 0, 3, 2});
+        SortIndices(table, columns, indices, {1, SortSpec::Key::Numeric, true});
+        CHECK(indices == std::vector<size_t>{3, 0, 1, 2});
+    }
+
+    SECTION("only the given subset is reordered") {
+        std::vector<size_t> subset = {3, 0};
+        SortIndices(table, columns, subset, {1, SortSpec::Key::Numeric, false});
+        CHECK(subset == std::vector<size_t>{0, 3});
+    }
+
+    SECTION("missing column sorts as empty") {
+        SortIndices(table, columns, indices, {5, SortSpec::Key::Lexical, false});
+        CHECK(indices == std::vector<size_t>{0, 1, 2, 3});
+    }
+}
+
+TEST_CASE("ColumnCache reparses after the table changes", "[query]") {
+    RowTable table = MakeTable({"1", "2"});
+    ColumnCache columns;
+    CHECK(columns.Numeric(table, 0).values.size() == 2);
+
+    table.AddLine("3", '|');
+    const auto& values = columns.Numeric(table, 0).values;
+    REQUIRE(values.size() == 3);
+    CHECK(values[2] == 3);
+}
+
+TEST_CASE("ParallelSort matches std::sort", "[query]") {
+    std::mt19937 rng(42);
+    std::vector<int> values(200'000);
+    for (int& v : values) v = static_cast<int>(rng() % 1000);
+
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    ParallelSort(values.begin(), values.end(), std::less<>{}, 1000);
+    CHECK(values == expected);
+}
+
+TEST_CASE("ParsePredicate", "[query]") {
+    SECTION("numeric comparison") {
+        auto predicate = ParsePredicate({"3", ">", "500"});
+        REQUIRE(predicate);
+        CHECK(predicate->column == 3);
+        CHECK(predicate->op == Predicate::Op::Greater);
+        CHECK(predicate->numeric);
+        CHECK(predicate->number == 500);
+    }
+
+    SECTION("string value with spaces") {
+        auto predicate = ParsePredicate({"1", "==", "not", "found"});
+        REQUIRE(predicate);
+        CHECK_FALSE(predicate->numeric);
+        CHECK(predicate->value == "not found");
+    }
+
+    SECTION("prefix is never numeric") {
+        auto predicate = ParsePredicate({"0", "~", "12"});
+        REQUIRE(predicate);
+        CHECK(predicate->op == Predicate::Op::Prefix);
+        CHECK_FALSE(predicate->numeric);
+    }
+
+    SECTION("rejects bad input") {
+        CHECK_FALSE(ParsePredicate({"1", "=="}));
+        CHECK_FALSE(ParsePredicate({"x", "==", "1"}));
+        CHECK_FALSE(ParsePredicate({"1", "<>", "1"}));
+    }
+}
+
+TEST_CASE("FilterIndices evaluates predicates", "[query]") {
+    RowTable table = MakeTable({"ERROR|700|/usr/bin", "INFO|20|/usr/lib", "ERROR|x|/etc", "WARN|500"});
+    ColumnCache columns;
+    auto all = AllRows(table);
+
+    auto filter = [&](std::vector<std::string> args, const std::vector<size_t>& indices) {
+        auto predicate = ParsePredicate(args);
+        REQUIRE(predicate);
+        return FilterIndices(table, columns, indices, *predicate);
+    };
+
+    CHECK(filter({"0", "==", "ERROR"}, all) == std::vector<size_t>{0, 2});
+    CHECK(filter({"0", "!=", "ERROR"}, all) == std::vector<size_t>{1, 3});
+    CHECK(filter({"1", ">", "100"}, all) == std::vector<size_t>{0, 3});
+    CHECK(filter({"1", "<=", "500"}, all) == std::vector<size_t>{1, 3});
+    CHECK(filter({"1", "!=", "20"}, all) == std::vector<size_t>{0, 2, 3});
+    CHECK(filter({"2", "~", "/usr"}, all) == std::vector<size_t>{0, 1});
+    CHECK(filter({"0", "<", "INFO"}, all) == std::vector<size_t>{0, 2});
+
+    SECTION("keeps the order of the input indices") {
+        CHECK(filter({"1", ">", "100"}, {3, 1, 0}) == std::vector<size_t>{3, 0});
+    }
+}
+
+TEST_CASE("FilterIndices splits large inputs across batches and threads", "[query]") {
+    RowTable table;
+    for (int i = 0; i < 100'000; ++i) table.AddLine(std::to_string(i), '|');
+    ColumnCache columns;
+
+    auto predicate = ParsePredicate({"0", ">=", "99000"});
+    REQUIRE(predicate);
+    auto result = FilterIndices(table, columns, AllRows(table), *predicate);
+    REQUIRE(result.size() == 1000);
+    CHECK(std::is_sorted(result.begin(), result.end()));
+    CHECK(result.front() == 99000);
+}
+
+TEST_CASE("GroupIndices aggregates per key", "[query]") {
+    RowTable table = MakeTable({"web|10", "db|5", "web|x", "web|30", "cache"});
+    ColumnCache columns;
+    auto all = AllRows(table);
+
+    SECTION("count only") {
+        auto spec = ParseGroupSpec({"0"});
+        REQUIRE(spec);
+        auto groups = GroupIndices(table, columns, all, *spec);
+        REQUIRE(groups.size() == 3);
+        CHECK(groups[0].key == "web");
+        CHECK(groups[0].members == std::vector<size_t>{0, 2, 3});
+        CHECK(groups[1].key == "cache");
+        CHECK(groups[2].key == "db");
+    }
+
+    SECTION("with a numeric value column") {
+        auto spec = ParseGroupSpec({"0", "1"});
+        REQUIRE(spec);
+        auto groups = GroupIndices(table, columns, all, *spec);
+        REQUIRE(groups[0].key == "web");
+        CHECK(groups[0].numericCount == 2);
+        CHECK(groups[0].sum == 40);
+        CHECK(groups[0].min == 10);
+        CHECK(groups[0].max == 30);
+
+        auto view = GroupsToRowTable(groups, true);
+        REQUIRE(view.data.size() == 3);
+        CHECK(view[0] == RowTable::row_t{"web", "3", "40", "10", "30"});
+        CHECK(view[1] == RowTable::row_t{"cache", "1", "0", "", ""});
+    }
+
+    SECTION("members follow the order of the grouped indices") {
+        auto groups = GroupIndices(table, columns, std::vector<size_t>{3, 1, 0}, {0, std::nullopt});
+        REQUIRE(groups.size() == 2);
+        CHECK(groups[0].members == std::vector<size_t>{3, 0});
+    }
+
+    SECTION("rejects bad input") {
+        CHECK_FALSE(ParseGroupSpec({}));
+        CHECK_FALSE(ParseGroupSpec({"a"}));
+        CHECK_FALSE(ParseGroupSpec({"0", "1", "2"}));
+    }
+}
+
+TEST_CASE("GroupIndices merges per-thread partial tables", "[query]") {
+    RowTable table;
+    for (int i = 0; i < 100'000; ++i) {
+        table.AddLine("host" + std::to_string(i % 7) + "|" + std::to_string(i), '|');
+    }
+    ColumnCache columns;
+
+    auto groups = GroupIndices(table, columns, AllRows(table), {0, 1});
+    REQUIRE(groups.size() == 7);
+
+    size_t total = 0;
+    for (const auto& group : groups) {
+        total += group.members.size();
+        CHECK(std::is_sorted(group.members.begin(), group.members.end()));
+    }
+    CHECK(total == 100'000);
+    CHECK(groups[0].key == "host0");
+    CHECK(groups[0].min == 0);
+}
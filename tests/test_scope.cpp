@@ -0,0 +1,305 @@
+#include <catch2/catch_test_macros.hpp>
+#include "scope.hpp"
+#include "stat_cache.hpp"
+#include "datagen.hpp"
+#include "utils.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <string>
+#include <thread>
+
+static const std::string testDir = "/tmp/fxf_test_scope";
+
+// The patterns Parse used before it was hand-written; the scanners must agree with them.
+static const std::regex vimgrepRegex(R"(^(.+?):(\d+):(\d+):.*$)");
+static const std::regex grepRegex(R"(^(.+?):(\d+):.*$)");
+static const std::regex urlRegex(
+    R"(https?://(?:www\.)?[-a-zA-Z0-9@:%._+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b[-a-zA-Z0-9()@:%_+.~#?&/=]*)",
+    std::regex::icase);
+
+static void CheckAgainstRegex(const std::string& text)
+{
+    INFO(text);
+    LineReferences refs = FindLineReferences(text);
+    std::smatch match;
+
+    REQUIRE(refs.vimgrep.has_value() == std::regex_match(text, match, vimgrepRegex));
+    if (refs.vimgrep) {
+        CHECK(refs.vimgrep->path == match[1].str());
+        CHECK(refs.vimgrep->line == std::stoi(match[2].str()));
+        CHECK(refs.vimgrep->col == std::stoi(match[3].str()));
+    }
+
+    REQUIRE(refs.grep.has_value() == std::regex_match(text, match, grepRegex));
+    if (refs.grep) {
+        CHECK(refs.grep->path == match[1].str());
+        CHECK(refs.grep->line == std::stoi(match[2].str()));
+    }
+
+    std::string url = std::regex_search(text, match, urlRegex) ? match[0].str() : "";
+    CHECK(std::string(FindURL(text)) == url);
+}
+
+TEST_CASE("FindLineReferences and FindURL agree with the regexes they replace", "[scope]") {
+    SECTION("generated vimgrep output") {
+        DataGenerator generator({.shape = DataShape::Vimgrep, .rows = 2000, .delimiter = ':'});
+        for (std::string line; generator.AppendNext(line); line.clear()) {
+            CheckAgainstRegex(line);
+        }
+    }
+
+    SECTION("edge cases") {
+        for (const char* text : {
+                 "", ":", "a:", ":1:", ":1:2:", "a:1:", "a:1:2:", "a:1:2", "a:1", "a::1:2:",
+                 "a:b:1:2:text", "a:1:b:2:3:", "a:1:2:3:4:", "C:/dir/file.txt:10:5:text",
+                 "file.cpp:42:  int x = 1;", "file.cpp:42:7:int x: y:",
+                 "a:12x:3:", "a:1:2x:", "a:1:\n2:", "a:1:2:\rb", "\xc3\xa9t\xc3\xa9:3:4:caf\xc3\xa9",
+                 "https://example.com", "see HTTPS://Example.COM/x?y=1 and http://b.org",
+                 "http://a.b", "http://a.bc_", "http://a.bcdefgh", "http://a.bcdefg.h",
+                 "http://.com", "http://a..com", "http://a.(b)/p", "xhttp://a.io", "http://a.io.",
+                 "https://www.example.com:8080/path#frag", "http://localhost:8080/",
+                 "a:1:http://example.com",
+             }) {
+            CheckAgainstRegex(text);
+        }
+    }
+}
+
+TEST_CASE("FindLineReferences drops numbers that overflow", "[scope]") {
+    LineReferences refs = FindLineReferences("a:99999999999:1:text");
+    CHECK_FALSE(refs.vimgrep.has_value());
+    CHECK_FALSE(refs.grep.has_value());
+
+    refs = FindLineReferences("a:5:99999999999:text");
+    CHECK_FALSE(refs.vimgrep.has_value());
+    REQUIRE(refs.grep.has_value());
+    CHECK(refs.grep->line == 5);
+}
+
+TEST_CASE("StatCache answers from one stat per path", "[scope][stat]") {
+    std::filesystem::remove_all(testDir);
+    std::filesystem::create_directories(testDir);
+    const std::string file = testDir + "/file.txt";
+    std::ofstream(file) << "hello";
+
+    StatCache stats;
+    StatCache::Info info = stats.Get(file);
+    CHECK(info.IsFile());
+    CHECK_FALSE(info.IsDirectory());
+    CHECK(info.size == 5);
+    CHECK(stats.Get(testDir).IsDirectory());
+    CHECK_FALSE(stats.Get(testDir + "/missing").exists);
+    CHECK(stats.Calls() == 3);
+
+    // Within the TTL, changes go unseen until the path is forgotten
+    std::filesystem::remove(file);
+    CHECK(stats.Get(file).IsFile());
+    CHECK(stats.Calls() == 3);
+    stats.Forget(file);
+    CHECK_FALSE(stats.Get(file).exists);
+    CHECK(stats.Calls() == 4);
+
+    SECTION("expired entries are refreshed") {
+        StatCache shortLived(std::chrono::milliseconds(1));
+        CHECK(shortLived.Get(testDir).IsDirectory());
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        CHECK(shortLived.Get(testDir).IsDirectory());
+        CHECK(shortLived.Calls() == 2);
+    }
+
+    SECTION("a full cache starts over") {
+        StatCache small(StatCache::kDefaultTtl, 2);
+        small.Get("/a");
+        small.Get("/b");
+        CHECK(small.Size() == 2);
+        small.Get("/c");
+        CHECK(small.Size() == 1);
+        small.Clear();
+        CHECK(small.Size() == 0);
+    }
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("Scope::Parse detects content types", "[scope]") {
+    std::filesystem::remove_all(testDir);
+    std::filesystem::create_directories(testDir + "/dir");
+    const std::string file = testDir + "/main.cpp";
+    std::ofstream(file) << "int main() {}\n";
+
+    Scope scope;
+
+    ParsedContent parsed = scope.Parse(file + ":12:3:  int x;");
+    CHECK(parsed.type == ContentType::VimgrepOutput);
+    CHECK(parsed.filepath == file);
+    CHECK(parsed.line == 12);
+    CHECK(parsed.col == 3);
+
+    parsed = scope.Parse("  " + file + ":7:text: with colons\n");
+    CHECK(parsed.type == ContentType::GrepOutput);
+    CHECK(parsed.filepath == file);
+    CHECK(parsed.line == 7);
+
+    parsed = scope.Parse(file);
+    CHECK(parsed.type == ContentType::FilePath);
+    CHECK(parsed.filepath == file);
+
+    parsed = scope.Parse(testDir + "/dir");
+    CHECK(parsed.type == ContentType::Directory);
+
+    parsed = scope.Parse("docs at https://example.com/guide");
+    CHECK(parsed.type == ContentType::URL);
+    CHECK(parsed.url == "https://example.com/guide");
+
+    // A reference to a file that does not exist is just text
+    parsed = scope.Parse(testDir + "/missing.cpp:1:2:text");
+    CHECK(parsed.type == ContentType::Unknown);
+    CHECK(scope.Parse("   ").type == ContentType::Unknown);
+
+    // ClearCache forgets file status, so a new file is seen right away
+    const std::string later = testDir + "/later.txt";
+    CHECK(scope.Parse(later).type == ContentType::Unknown);
+    std::ofstream(later) << "now";
+    scope.ClearCache();
+    CHECK(scope.Parse(later).type == ContentType::FilePath);
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("Scope::ProcessCommand renders and caches command output", "[scope][coprocess]") {
+    Scope scope;
+
+    CHECK(scope.ProcessCommand("echo from shell") == "from shell\n");
+    CHECK(scope.CachedCommand("echo from shell") != nullptr);
+    CHECK(scope.Cached("echo from shell") == nullptr);
+
+    // Errors stay off the terminal
+    CHECK(scope.ProcessCommand("echo oops >&2; echo ok") == "ok\n");
+
+    // Output cut short by the sink is shown but not cached, so a later render
+    // without a budget gets all of it
+    const std::string lines = "seq 1 100000";
+    std::string partial = scope.ProcessCommand(lines, {}, false, [](std::string_view) { return false; });
+    CHECK(partial.starts_with("1\n2\n"));
+    CHECK(scope.CachedCommand(lines) == nullptr);
+    std::string whole = scope.ProcessCommand(lines);
+    CHECK(whole.ends_with("\n100000\n"));
+    CHECK(scope.CachedCommand(lines) != nullptr);
+
+    SECTION("with a preview helper") {
+        scope.SetPreviewHelper("while read n; do p=$(head -c \"$n\"); "
+                               "out=\"helper: $p\"; printf '%s\\n%s' \"${#out}\" \"$out\"; done");
+        REQUIRE(scope.PreviewHelper() != nullptr);
+
+        // The helper is part of the cache key, so shell results are not reused
+        CHECK(scope.CachedCommand("echo from shell") == nullptr);
+        CHECK(scope.ProcessCommand("echo from shell") == "helper: echo from shell");
+        CHECK(scope.ProcessCommand("second") == "helper: second");
+        CHECK(scope.PreviewHelper()->Starts() == 1);
+
+        // A response cut short by the sink is shown but not cached
+        const std::string big(200'000, 'x');
+        size_t calls = 0;
+        std::string partial = scope.ProcessCommand(big, {}, false, [&](std::string_view) { return ++calls < 1; });
+        CHECK(calls == 1);
+        CHECK(partial.size() < big.size());
+        CHECK(scope.CachedCommand(big) == nullptr);
+
+        scope.SetPreviewHelper("exit 1");
+        std::string failed = scope.ProcessCommand("x");
+        CHECK(failed.starts_with("[Preview helper exited"));
+        CHECK(scope.CachedCommand("x") == nullptr);
+    }
+}
+
+TEST_CASE("Scope memory accounting can be read while previews render", "[scope][threads]") {
+    std::filesystem::remove_all(testDir);
+    std::filesystem::create_directories(testDir);
+    constexpr int kFiles = 200;
+    for (int i = 0; i < kFiles; ++i) {
+        std::ofstream(testDir + "/" + std::to_string(i) + ".txt") << "line one\nline " << i << "\n";
+    }
+
+    // The memory report reads these on the UI thread while the pool renders
+    Scope scope;
+    std::atomic<bool> done{false};
+    std::jthread renderer([&] {
+        for (int i = 0; i < kFiles; ++i) {
+            scope.Process(testDir + "/" + std::to_string(i) + ".txt:2:1:line");
+        }
+        done = true;
+    });
+
+    size_t seen = 0;
+    while (!done) {
+        seen = std::max(seen, scope.CacheEntries());
+        (void)scope.CacheBytes();
+        (void)scope.LineIndexes().HeapBytes();
+    }
+    renderer.join();
+
+    CHECK(seen <= kFiles);
+    CHECK(scope.CacheEntries() == kFiles);
+    CHECK(scope.CacheBytes() > 0);
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("Directory listings are not served from the disk cache", "[scope]") {
+    std::filesystem::remove_all(testDir);
+    std::filesystem::create_directories(testDir + "/dir");
+    const std::string child = testDir + "/dir/child.txt";
+    const std::string cacheDir = testDir + "/cache";
+    std::ofstream(child) << "abc";
+
+    {
+        Scope scope;
+        REQUIRE(scope.OpenDiskCache(cacheDir));
+        scope.Process(child);
+        CHECK(scope.Process(testDir + "/dir").find(" 3 ") != std::string::npos);
+    }
+
+    // Rewriting a child leaves the directory's own size and mtime alone
+    std::ofstream(child) << std::string(4321, 'x');
+
+    Scope later;
+    REQUIRE(later.OpenDiskCache(cacheDir));
+    CHECK(later.DiskStore()->Entries() == 1);
+    CHECK(later.Process(testDir + "/dir").find(" 4321 ") != std::string::npos);
+
+    std::filesystem::remove_all(testDir);
+}
+
+TEST_CASE("Scope::Process does not cache output cut short by its sink", "[scope]") {
+    // A stand-in w3m, found first on PATH, so no network is needed
+    std::filesystem::remove_all(testDir);
+    std::filesystem::create_directories(testDir);
+    const std::string fakeW3m = testDir + "/w3m";
+    std::ofstream(fakeW3m) << "#!/bin/sh\nfor i in 1 2 3 4 5; do echo \"line $i\"; done\n";
+    std::filesystem::permissions(fakeW3m, std::filesystem::perms::owner_all);
+    const std::string path = getenv("PATH");
+    setenv("PATH", (testDir + ":" + path).c_str(), 1);
+
+    const std::string input = "docs at https://example.com/page";
+    Scope scope;
+
+    std::string seen;
+    std::string partial = scope.Process(input, {}, false, [&](std::string_view chunk) {
+        seen += chunk;
+        return false;
+    });
+    CHECK(partial.starts_with("line 1\n"));
+    CHECK(partial == seen);
+    CHECK(scope.Cached(input) == nullptr);
+
+    // Without a budget the whole output is read and cached
+    std::string whole = scope.Process(input);
+    CHECK(whole == "line 1\nline 2\nline 3\nline 4\nline 5\n");
+    REQUIRE(scope.Cached(input) != nullptr);
+    CHECK(*scope.Cached(input) == whole);
+
+    setenv("PATH", path.c_str(), 1);
+    std::filesystem::remove_all(testDir);
+}
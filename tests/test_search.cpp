@@ -0,0 +1,51 @@
+#include <catch2/catch_test_macros.hpp>
+#include "search.hpp"
+#include "alloc_hook.hpp"
+#include "datagen.hpp"
+
+#include <numeric>
+
+static std::vector<std::string> MakeLabels(size_t rows)
+{
+    std::vector<std::string> labels;
+    DataGenerator generator({.shape = DataShape::Vimgrep, .rows = rows});
+    for (std::string line; generator.AppendNext(line); line.clear()) {
+        labels.push_back(line);
+    }
+    return labels;
+}
+
+TEST_CASE("RankMatchesInto ranks like RankMatches", "[search]") {
+    const auto labels = MakeLabels(2000);
+    std::vector<size_t> candidates(labels.size());
+    std::iota(candidates.begin(), candidates.end(), 0);
+
+    std::vector<size_t> ranked = {42, 43};   // Replaced, not appended to
+    RankScratch scratch;
+    for (const std::string query : {"src", "Parser", "tests/"}) {
+        RankMatchesInto(query, labels, candidates, ranked, scratch);
+        CHECK(ranked == RankMatches(query, labels, candidates));
+    }
+}
+
+TEST_CASE("RankMatchesInto does not allocate per row once warmed up", "[search][alloc]") {
+    const auto labels = MakeLabels(20'000);
+    std::vector<size_t> candidates(labels.size());
+    std::iota(candidates.begin(), candidates.end(), 0);
+
+    const std::string queries[] = {"s", "sr", "src", "src/", "src/m", "Src"};
+    std::vector<size_t> ranked;
+    RankScratch scratch;
+    auto typeAll = [&] {
+        for (const std::string& query : queries) {
+            RankMatchesInto(query, labels, candidates, ranked, scratch);
+        }
+    };
+
+    typeAll();
+    AllocationCounter counter;
+    typeAll();
+
+    // Only the scorer's per-query setup may allocate; nothing scales with rows.
+    CHECK(counter.Count() <= std::size(queries) * 8);
+}
@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+#include "template.hpp"
+
+TEST_CASE("CompiledTemplate renders like substitute_template", "[template]") {
+    std::vector<std::string> data = {"apple", "banana", "cherry"};
+
+    SECTION("literal only") {
+        CompiledTemplate tpl("hello world");
+        CHECK_FALSE(tpl.HasPlaceholders());
+        CHECK(tpl.Render(data) == "hello world");
+    }
+
+    SECTION("fields and all-fields") {
+        CompiledTemplate tpl("{2}: {} ({0})");
+        CHECK(tpl.HasPlaceholders());
+        CHECK(tpl.Render(data) == "cherry: apple | banana | cherry (apple)");
+    }
+
+    SECTION("missing field falls back per row") {
+        CompiledTemplate tpl("{0}-{2}");
+        CHECK(tpl.Render(data) == "apple-cherry");
+        CHECK(tpl.Render({"x"}) == "x-{2}");
+    }
+
+    SECTION("malformed placeholders stay literal") {
+        CHECK(CompiledTemplate("{a}{1}").Render(data) == "{a}banana");
+        CHECK(CompiledTemplate("{{0}}").Render(data) == "{{0}}");
+        CHECK(CompiledTemplate("{1} {").Render(data) == "banana {");
+    }
+
+    SECTION("source is preserved") {
+        CompiledTemplate tpl("{0} | {1}");
+        CHECK(tpl.Source() == "{0} | {1}");
+    }
+}
+
+TEST_CASE("CompiledTemplate size estimate is exact", "[template]") {
+    std::vector<std::string> data = {"apple", "banana", "cherry"};
+
+    for (std::string_view src : {"", "abc", "{}", "{0}{1}{2}", "[{1}] {} {9}", "{x} {"}) {
+        CompiledTemplate tpl(src);
+        CHECK(tpl.EstimateSize(data) == tpl.Render(data).size());
+        CHECK(tpl.EstimateSize({}) == tpl.Render({}).size());
+    }
+}
+
+TEST_CASE("CompiledTemplate RenderInto appends", "[template]") {
+    CompiledTemplate tpl("<{0}>");
+    std::string out = "rows:";
+    tpl.RenderInto(out, {"a"});
+    tpl.RenderInto(out, {"b"});
+    CHECK(out == "rows:<a><b>");
+}
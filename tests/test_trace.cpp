@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include "trace.hpp"
+#include "perf.hpp"
+
+#include <memory>
+#include <thread>
+
+// Writes the trace to a temporary file and returns the JSON.
+static std::string DumpTrace()
+{
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file(std::tmpfile(), std::fclose);
+    REQUIRE(file);
+    REQUIRE(Trace::WriteJson(file.get()));
+
+    std::rewind(file.get());
+    std::string json;
+    char buffer[4096];
+    for (size_t n; (n = std::fread(buffer, 1, sizeof buffer, file.get())) > 0;) {
+        json.append(buffer, n);
+    }
+    return json;
+}
+
+static size_t Occurrences(std::string_view text, std::string_view needle)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string_view::npos; pos = text.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+TEST_CASE("Trace records spans from several threads", "[trace]") {
+    Trace::Start();
+
+    { TraceSpan span("test-main-span", "say \"hi\""); }
+    Trace::Instant("test-instant");
+    Trace::AsyncBegin("test-async", 7);
+    std::jthread([] {
+        Trace::SetThreadName("test-worker");
+        TraceSpan span("test-worker-span");
+    }).join();
+    Trace::AsyncEnd("test-async", 7);
+    { ScopedTimer timer(PerfStage::Sort, "rows", 42); }
+
+    Trace::Stop();
+    { TraceSpan span("test-after-stop"); }
+    Trace::Instant("test-after-stop");
+
+    const std::string json = DumpTrace();
+
+    CHECK(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    CHECK(json.ends_with("}}\n"));
+    CHECK(Occurrences(json, "\"name\":\"test-main-span\"") == 1);
+    CHECK(Occurrences(json, "\"detail\":\"say \\\"hi\\\"\"") == 1);
+    CHECK(Occurrences(json, "\"name\":\"test-instant\"") == 1);
+    CHECK(Occurrences(json, "\"name\":\"test-async\"") == 2);
+    CHECK(Occurrences(json, "\"name\":\"test-worker\"") == 1);
+    CHECK(Occurrences(json, "\"name\":\"test-worker-span\"") == 1);
+    CHECK(Occurrences(json, "\"rows\":42") == 1);
+    CHECK(Occurrences(json, "test-after-stop") == 0);
+
+    // The worker's span is attributed to a different thread than the main one.
+    auto tidOf = [&json](std::string_view name) {
+        size_t pos = json.find(name);
+        REQUIRE(pos != std::string::npos);
+        size_t tid = json.find("\"tid\":", pos);
+        return json.substr(tid, json.find(',', tid) - tid);
+    };
+    CHECK(tidOf("\"test-main-span\"") != tidOf("\"test-worker-span\""));
+    CHECK(tidOf("\"test-main-span\"") == tidOf("\"test-instant\""));
+}
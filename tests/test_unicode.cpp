@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include "unicode.hpp"
+
+#include <string>
+
+TEST_CASE("DisplayWidth counts terminal columns", "[unicode]") {
+    SECTION("ascii") {
+        CHECK(DisplayWidth("") == 0);
+        CHECK(DisplayWidth("hello") == 5);
+        CHECK(DisplayWidth(std::string(100, 'x')) == 100);
+    }
+
+    SECTION("multi-byte narrow characters") {
+        CHECK(DisplayWidth("café") == 4);
+        CHECK(DisplayWidth("über") == 4);
+    }
+
+    SECTION("wide characters") {
+        CHECK(DisplayWidth("日本") == 4);
+        CHECK(DisplayWidth("a\U0001F600b") == 4);
+    }
+
+    SECTION("combining marks are zero width") {
+        CHECK(DisplayWidth("é") == 1);
+    }
+
+    SECTION("invalid bytes count as one column") {
+        CHECK(DisplayWidth("a\xff" "b") == 3);
+        CHECK(DisplayWidth("\xe6\x97") == 2);
+    }
+}
+
+TEST_CASE("AsciiPrefixLength stops at the first non-ascii byte", "[unicode]") {
+    std::string text(40, 'a');
+    CHECK(AsciiPrefixLength(text.data(), text.size()) == 40);
+    for (size_t pos : {0, 7, 8, 15, 16, 17, 39}) {
+        std::string s = text;
+        s[pos] = '\xc3';
+        CHECK(AsciiPrefixLength(s.data(), s.size()) == pos);
+    }
+}
+
+TEST_CASE("CutToWidth cuts on code point boundaries", "[unicode]") {
+    SECTION("ascii") {
+        auto cut = CutToWidth("hello world", 5);
+        CHECK(cut.bytes == 5);
+        CHECK(cut.width == 5);
+    }
+
+    SECTION("text that fits is kept whole") {
+        auto cut = CutToWidth("café", 10);
+        CHECK(cut.bytes == 5);
+        CHECK(cut.width == 4);
+    }
+
+    SECTION("multi-byte character is never split") {
+        auto cut = CutToWidth("cafés", 4);
+        CHECK(cut.bytes == 5);
+        CHECK(cut.width == 4);
+    }
+
+    SECTION("wide character that does not fit is dropped") {
+        auto cut = CutToWidth("a日b", 2);
+        CHECK(cut.bytes == 1);
+        CHECK(cut.width == 1);
+    }
+
+    SECTION("combining mark stays with its base") {
+        auto cut = CutToWidth("éx", 1);
+        CHECK(cut.bytes == 3);
+        CHECK(cut.width == 1);
+    }
+
+    SECTION("zero width") {
+        CHECK(CutToWidth("abc", 0).bytes == 0);
+    }
+}
+
+TEST_CASE("ValidUtf8Length stops at the first invalid sequence", "[unicode]") {
+    CHECK(ValidUtf8Length("") == 0);
+    CHECK(ValidUtf8Length("plain ascii") == 11);
+    CHECK(ValidUtf8Length("café 日本 \U0001F600") == std::string("café 日本 \U0001F600").size());
+    CHECK(ValidUtf8Length("\xEF\xBF\xBD") == 3);           // An encoded U+FFFD is valid
+    CHECK(ValidUtf8Length("ab\xff" "cd") == 2);
+    CHECK(ValidUtf8Length("ab\xe6\x97") == 2);              // Truncated sequence
+    CHECK(ValidUtf8Length("ab\xc0\xaf") == 2);              // Overlong encoding
+    CHECK(ValidUtf8Length("ab\xed\xa0\x80") == 2);          // Surrogate
+}
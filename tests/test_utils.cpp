@@ -218,3 +218,31 @@ TEST_CASE("ExtractURLs finds all URLs", "[utils]") {
     }
 }
 
+
+TEST_CASE("IndexLines finds line starts", "[utils]") {
+    SECTION("empty text has no lines") {
+        CHECK(IndexLines("").empty());
+    }
+
+    SECTION("trailing newline does not add a line") {
+        CHECK(IndexLines("a\nbc\n") == std::vector<size_t>{0, 2});
+    }
+
+    SECTION("no trailing newline") {
+        CHECK(IndexLines("a\nbc") == std::vector<size_t>{0, 2});
+    }
+
+    SECTION("empty lines are kept") {
+        CHECK(IndexLines("\n\nx") == std::vector<size_t>{0, 1, 2});
+    }
+}
+
+TEST_CASE("ExtendLineIndex indexes appended text", "[utils]") {
+    const std::string text = "ab\ncd\n\nefg\nh\n";
+    for (size_t split = 0; split <= text.size(); ++split) {
+        INFO("split at " << split);
+        std::vector<size_t> starts = IndexLines(std::string_view(text).substr(0, split));
+        ExtendLineIndex(starts, text, split);
+        CHECK(starts == IndexLines(text));
+    }
+}